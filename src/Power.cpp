@@ -654,6 +654,9 @@ void Power::readPowerStatus()
             LOG_DEBUG("\n");
             LOG_DEBUG("Heap status: %d/%d bytes free (%d), running %d/%d threads\n", memGet.getFreeHeap(), memGet.getHeapSize(),
                       memGet.getFreeHeap() - lastheap, running, concurrency::mainController.size(false));
+            MemoryPoolStats poolStats = getPacketPoolStats();
+            LOG_DEBUG("Packet pool: %u/%u in use, high water %u, %u heap overflows\n", poolStats.inUse, poolStats.capacity,
+                      poolStats.highWater, poolStats.overflows);
             lastheap = memGet.getFreeHeap();
         }
 #ifdef DEBUG_HEAP_MQTT
@@ -279,6 +279,9 @@ void RedirectablePrint::log(const char *logLevel, const char *format, ...)
 #ifdef HAS_FREE_RTOS
     if (inDebugPrint != nullptr && xSemaphoreTake(inDebugPrint, portMAX_DELAY) == pdTRUE) {
 #else
+#ifdef HAS_STD_THREADS
+    std::lock_guard<std::recursive_mutex> guard(printLock);
+#endif
     if (!inDebugPrint) {
         inDebugPrint = true;
 #endif
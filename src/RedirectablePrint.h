@@ -6,6 +6,10 @@
 #include <stdarg.h>
 #include <string>
 
+#ifdef HAS_STD_THREADS
+#include <mutex>
+#endif
+
 /**
  * A Printable that can be switched to squirt its bytes to a different sink.
  * This class is mostly useful to allow debug printing to be redirected away from Serial
@@ -23,6 +27,10 @@ class RedirectablePrint : public Print
     StaticSemaphore_t _MutexStorageSpace;
 #else
     volatile bool inDebugPrint = false;
+#endif
+#ifdef HAS_STD_THREADS
+    /// Lets the portduino worker threads log too, recursive so a log from inside log() still gets skipped by inDebugPrint
+    std::recursive_mutex printLock;
 #endif
   public:
     explicit RedirectablePrint(Print *_dest) : dest(_dest) {}
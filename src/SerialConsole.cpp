@@ -97,6 +97,11 @@ bool SerialConsole::handleToRadio(const uint8_t *buf, size_t len)
 void SerialConsole::log_to_serial(const char *logLevel, const char *format, va_list arg)
 {
     if (usingProtobufs && config.device.debug_log_enabled) {
+        // The protobuf stream belongs to the main loop, so a worker thread's log can't go out on it (and as plain text it
+        // would break the framing for the client)
+        if (!concurrency::OSThread::isMainThread())
+            return;
+
         meshtastic_LogRecord_Level ll = meshtastic_LogRecord_Level_UNSET; // default to unset
         switch (logLevel[0]) {
         case 'D':
@@ -15,13 +15,32 @@ BinarySemaphorePosix::~BinarySemaphorePosix() {}
  */
 bool BinarySemaphorePosix::take(uint32_t msec)
 {
+#ifdef HAS_STD_THREADS
+    std::unique_lock<std::mutex> lock(mutex);
+    bool r = cond.wait_for(lock, std::chrono::milliseconds(msec), [this] { return given; });
+    given = false;
+    return r;
+#else
     delay(msec); // FIXME
     return false;
+#endif
 }
 
-void BinarySemaphorePosix::give() {}
+void BinarySemaphorePosix::give()
+{
+#ifdef HAS_STD_THREADS
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        given = true;
+    }
+    cond.notify_one();
+#endif
+}
 
-IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken) {}
+IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken)
+{
+    give();
+}
 
 } // namespace concurrency
 
@@ -2,6 +2,11 @@
 
 #include "../freertosinc.h"
 
+#ifdef HAS_STD_THREADS
+#include <condition_variable>
+#include <mutex>
+#endif
+
 namespace concurrency
 {
 
@@ -10,6 +15,11 @@ namespace concurrency
 class BinarySemaphorePosix
 {
     // SemaphoreHandle_t semaphore;
+#ifdef HAS_STD_THREADS
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool given = false;
+#endif
 
   public:
     BinarySemaphorePosix();
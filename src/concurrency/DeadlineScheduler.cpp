@@ -0,0 +1,175 @@
+#include "concurrency/DeadlineScheduler.h"
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+namespace concurrency
+{
+
+/// Deadlines further out than this are filed at this distance and re-checked when they come up, so that every key in the heap
+/// stays well within the range where wrapping (uint32_t) millis() arithmetic orders correctly
+#define MAX_FILE_AHEAD_MSEC (1UL << 30)
+
+bool DeadlineScheduler::add(OSThread *t)
+{
+    if (!ThreadController::add(t)) // still keep the base list, so get()/size() keep working for debug output
+        return false;
+
+    refile(t, millis());
+    return true;
+}
+
+void DeadlineScheduler::remove(OSThread *t)
+{
+    drainDirty(millis()); // make sure nothing on the dirty list still points at t
+    heapRemove(t);
+    for (size_t i = 0; i < due.size(); i++)
+        if (due[i] == t)
+            due[i] = NULL; // removed while runOrDelay() was busy with it
+
+    ThreadController::remove(t);
+}
+
+void DeadlineScheduler::markDirty(OSThread *t)
+{
+    if (t->dirty.exchange(true))
+        return; // already waiting to be refiled
+
+    OSThread *head = dirtyHead.load();
+    do {
+        t->dirtyNext = head;
+    } while (!dirtyHead.compare_exchange_weak(head, t));
+}
+
+void DeadlineScheduler::drainDirty(uint32_t now)
+{
+    OSThread *t = dirtyHead.exchange(NULL);
+    while (t) {
+        OSThread *next = t->dirtyNext;
+        t->dirty = false;
+        refile(t, now);
+        t = next;
+    }
+}
+
+long DeadlineScheduler::runOrDelay()
+{
+    uint32_t now = millis();
+    drainDirty(now);
+
+    // Take everything that is due up front, so each thread runs at most once per pass (like the old scan) even if it asks to run
+    // again immediately
+    due.clear();
+    while (!heap.empty() && (int32_t)(heap[0]->heapKey - now) <= 0) {
+        OSThread *t = heap[0];
+        heapRemove(t);
+        due.push_back(t);
+    }
+
+    for (size_t i = 0; i < due.size(); i++) {
+        OSThread *t = due[i];
+        bool woken = t->wakePending.exchange(false);
+
+        if (!t->enabled)
+            continue; // parked until the next setInterval() or wake()
+
+        if (woken || t->shouldRun(now))
+            t->run();
+
+        if (due[i]) // it might have removed itself
+            refile(t, millis());
+    }
+    due.clear();
+
+    now = millis();
+    drainDirty(now);
+
+    if (heap.empty())
+        return INT32_MAX;
+
+    int32_t wait = (int32_t)(heap[0]->heapKey - now);
+    return wait < 0 ? 0 : wait;
+}
+
+void DeadlineScheduler::refile(OSThread *t, uint32_t now)
+{
+    int32_t wait = 0;
+    if (!t->wakePending) {
+        wait = (int32_t)(t->_cached_next_run - now);
+        if (wait < 0)
+            wait = 0;
+        else if ((uint32_t)wait > MAX_FILE_AHEAD_MSEC)
+            wait = MAX_FILE_AHEAD_MSEC;
+    }
+    uint32_t oldKey = t->heapKey;
+    t->heapKey = now + wait;
+
+    if (t->heapIndex < 0) {
+        t->heapIndex = heap.size();
+        heap.push_back(t);
+        siftUp(t->heapIndex);
+    } else if ((int32_t)(t->heapKey - oldKey) < 0) {
+        siftUp(t->heapIndex);
+    } else {
+        siftDown(t->heapIndex);
+    }
+}
+
+void DeadlineScheduler::heapRemove(OSThread *t)
+{
+    int i = t->heapIndex;
+    if (i < 0)
+        return;
+
+    t->heapIndex = -1;
+    OSThread *last = heap.back();
+    heap.pop_back();
+    if (last != t) {
+        place(i, last);
+        siftUp(i);
+        siftDown(last->heapIndex);
+    }
+}
+
+bool DeadlineScheduler::keyBefore(const OSThread *a, const OSThread *b)
+{
+    return (int32_t)(a->heapKey - b->heapKey) < 0;
+}
+
+void DeadlineScheduler::place(int i, OSThread *t)
+{
+    heap[i] = t;
+    t->heapIndex = i;
+}
+
+void DeadlineScheduler::siftUp(int i)
+{
+    OSThread *t = heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!keyBefore(t, heap[parent]))
+            break;
+        place(i, heap[parent]);
+        i = parent;
+    }
+    place(i, t);
+}
+
+void DeadlineScheduler::siftDown(int i)
+{
+    OSThread *t = heap[i];
+    int n = heap.size();
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && keyBefore(heap[child + 1], heap[child]))
+            child++;
+        if (!keyBefore(heap[child], t))
+            break;
+        place(i, heap[child]);
+        i = child;
+    }
+    place(i, t);
+}
+
+} // namespace concurrency
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+#include "ThreadController.h"
+
+namespace concurrency
+{
+
+class OSThread;
+
+/**
+ * A ThreadController that keeps its OSThreads in a min-heap keyed on when they next want to run.
+ *
+ * runOrDelay() only touches the threads that are actually due and reads the time until the next one off the top of the heap,
+ * instead of asking every registered thread shouldRun() on every wake.
+ *
+ * Threads never touch the heap themselves: setInterval(), setIntervalFromNow() and wake() just push the thread onto a lock-free
+ * list, which runOrDelay() drains.  That keeps them safe to call from ISRs and other OS threads, as before.
+ *
+ * A thread that comes due while disabled is parked (dropped from the heap) until its next setInterval() or wake(), so code that
+ * re-enables a thread must also call one of those.
+ */
+class DeadlineScheduler : public ThreadController
+{
+    /// Binary min-heap ordered by OSThread::heapKey
+    std::vector<OSThread *> heap;
+
+    /// Threads taken off the heap for the pass runOrDelay() is currently doing
+    std::vector<OSThread *> due;
+
+    /// Lock-free stack of threads whose deadline changed since the last drain
+    std::atomic<OSThread *> dirtyHead;
+
+  public:
+    DeadlineScheduler() : dirtyHead(NULL) {}
+
+    bool add(OSThread *t);
+
+    void remove(OSThread *t);
+
+    /**
+     * Run every thread that is due (each at most once), and return how many msecs until the next one wants to run.
+     */
+    long runOrDelay();
+
+    /// Called (from any context) when t's deadline may have changed
+    void markDirty(OSThread *t);
+
+  private:
+    /// Pull everything off the dirty list and move it to the right place in the heap
+    void drainDirty(uint32_t now);
+
+    /// Recompute t's key and insert it into / move it within the heap
+    void refile(OSThread *t, uint32_t now);
+
+    /// Heap order, wrap safe
+    static bool keyBefore(const OSThread *a, const OSThread *b);
+
+    void heapRemove(OSThread *t);
+    void siftUp(int i);
+    void siftDown(int i);
+    void place(int i, OSThread *t);
+};
+
+} // namespace concurrency
@@ -21,6 +21,18 @@ void Lock::unlock()
 {
     assert(xSemaphoreGive(handle));
 }
+#elif defined(HAS_STD_THREADS)
+Lock::Lock() {}
+
+void Lock::lock()
+{
+    handle.lock();
+}
+
+void Lock::unlock()
+{
+    handle.unlock();
+}
 #else
 Lock::Lock() {}
 
@@ -2,6 +2,10 @@
 
 #include "../freertosinc.h"
 
+#ifdef HAS_STD_THREADS
+#include <mutex>
+#endif
+
 namespace concurrency
 {
 
@@ -29,6 +33,8 @@ class Lock
   private:
 #ifdef HAS_FREE_RTOS
     SemaphoreHandle_t handle;
+#elif defined(HAS_STD_THREADS)
+    std::mutex handle;
 #endif
 };
 
@@ -1,7 +1,9 @@
 #include "OSThread.h"
 #include "configuration.h"
 #include "memGet.h"
+#include <algorithm>
 #include <assert.h>
+#include <vector>
 
 namespace concurrency
 {
@@ -15,19 +17,27 @@ bool OSThread::showRun = false;
 /// Show debugging info for threads we decide not to run;
 bool OSThread::showWaiting = false;
 
+#ifdef HAS_STD_THREADS
+thread_local const OSThread *OSThread::currentThread;
+std::thread::id OSThread::mainThreadId;
+#else
 const OSThread *OSThread::currentThread;
+#endif
 
-ThreadController mainController, timerController;
+DeadlineScheduler mainController, timerController;
 InterruptableDelay mainDelay;
 
 void OSThread::setup()
 {
     mainController.ThreadName = "mainController";
     timerController.ThreadName = "timerController";
+#ifdef HAS_STD_THREADS
+    mainThreadId = std::this_thread::get_id();
+#endif
 }
 
-OSThread::OSThread(const char *_name, uint32_t period, ThreadController *_controller)
-    : Thread(NULL, period), controller(_controller)
+OSThread::OSThread(const char *_name, uint32_t period, DeadlineScheduler *_controller)
+    : Thread(NULL, period), controller(_controller), wakePending(false), dirty(false)
 {
     assertIsSetup();
 
@@ -55,6 +65,25 @@ void OSThread::setIntervalFromNow(unsigned long _interval)
 
     // Cache the next run based on the last_run
     _cached_next_run = millis() + interval;
+
+    if (controller)
+        controller->markDirty(this);
+}
+
+void OSThread::setInterval(unsigned long _interval)
+{
+    Thread::setInterval(_interval);
+
+    if (controller)
+        controller->markDirty(this);
+}
+
+void OSThread::wake()
+{
+    wakePending = true;
+
+    if (controller)
+        controller->markDirty(this);
 }
 
 bool OSThread::shouldRun(unsigned long time)
@@ -82,7 +111,10 @@ void OSThread::run()
     auto heap = memGet.getFreeHeap();
 #endif
     currentThread = this;
+    uint32_t startMsec = millis();
+    uint32_t startUsec = micros();
     auto newDelay = runOnce();
+    recordRun(micros() - startUsec, startMsec);
 #ifdef DEBUG_HEAP
     auto newHeap = memGet.getFreeHeap();
     if (newHeap < heap)
@@ -99,6 +131,50 @@ void OSThread::run()
     currentThread = NULL;
 }
 
+void OSThread::recordRun(uint32_t usec, uint32_t startMsec)
+{
+    stats.runs++;
+    stats.totalUsec += usec;
+    if (usec > stats.maxUsec)
+        stats.maxUsec = usec;
+
+    int32_t late = (int32_t)(startMsec - heapKey); // heapKey is when the controller found us due
+    if (late > 0) {
+        stats.totalLateMsec += late;
+        if ((uint32_t)late > stats.maxLateMsec)
+            stats.maxLateMsec = late;
+    }
+
+    int bucket = 0;
+    while (bucket < THREAD_STATS_BUCKETS - 1 && usec >= bucketLimitUsec(bucket))
+        bucket++;
+    stats.histogram[bucket]++;
+}
+
+void OSThread::logAllStats()
+{
+    std::vector<OSThread *> threads;
+    for (int i = 0; i < MAX_THREADS; i++) {
+        auto thread = static_cast<OSThread *>(mainController.get(i)); // DeadlineScheduler only holds OSThreads
+        if (thread)
+            threads.push_back(thread);
+    }
+    std::sort(threads.begin(), threads.end(),
+              [](const OSThread *a, const OSThread *b) { return a->stats.totalUsec > b->stats.totalUsec; });
+
+    LOG_INFO("Thread stats (runs, total/max runOnce msec, avg/max late msec, runOnce usec histogram <256/1k/4k/16k/65k/more):\n");
+    for (auto thread : threads) {
+        const ThreadStats &st = thread->stats;
+        if (!st.runs)
+            continue;
+        LOG_INFO("  %-20s %8u %8u %6u %6u %6u", thread->ThreadName.c_str(), st.runs, (uint32_t)(st.totalUsec / 1000),
+                 st.maxUsec / 1000, (uint32_t)(st.totalLateMsec / st.runs), st.maxLateMsec);
+        for (int i = 0; i < THREAD_STATS_BUCKETS; i++)
+            LOG_INFO(" %u", st.histogram[i]);
+        LOG_INFO("\n");
+    }
+}
+
 int32_t OSThread::disable()
 {
     enabled = false;
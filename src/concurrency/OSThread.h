@@ -1,20 +1,46 @@
 #pragma once
 
+#include <atomic>
 #include <cstdlib>
 #include <stdint.h>
 
+#include "../freertosinc.h"
 #include "Thread.h"
-#include "ThreadController.h"
+#include "concurrency/DeadlineScheduler.h"
 #include "concurrency/InterruptableDelay.h"
 
+#ifdef HAS_STD_THREADS
+#include <thread>
+#endif
+
 namespace concurrency
 {
 
-extern ThreadController mainController, timerController;
+extern DeadlineScheduler mainController, timerController;
 extern InterruptableDelay mainDelay;
 
 #define RUN_SAME -1
 
+/// Number of runOnce() duration buckets in ThreadStats, each one 4x as wide as the last starting at <256us
+#ifndef THREAD_STATS_BUCKETS
+#define THREAD_STATS_BUCKETS 6
+#endif
+
+/**
+ * Runtime profile of one OSThread, updated every time run() is called.
+ *
+ * Lateness is measured from when the controller found us due (or was told to wake us) to when it actually got to run us, so
+ * a thread that shows up here as late was kept waiting by whoever ran before it.
+ */
+struct ThreadStats {
+    uint32_t runs;
+    uint64_t totalUsec;  // sum of runOnce() durations
+    uint32_t maxUsec;    // longest single runOnce()
+    uint64_t totalLateMsec;
+    uint32_t maxLateMsec;
+    uint32_t histogram[THREAD_STATS_BUCKETS]; // runOnce() durations, see bucketLimitUsec()
+};
+
 /**
  * @brief Base threading
  *
@@ -30,7 +56,24 @@ extern InterruptableDelay mainDelay;
  */
 class OSThread : public Thread
 {
-    ThreadController *controller;
+    friend class DeadlineScheduler;
+
+    DeadlineScheduler *controller;
+
+    /// Our position in the controller's heap, or -1 if we are parked (or not filed yet)
+    int heapIndex = -1;
+
+    /// The time the controller has us filed under
+    uint32_t heapKey = 0;
+
+    /// Set by wake(), cleared when the controller runs us
+    std::atomic<bool> wakePending;
+
+    /// Set while we are on the controller's dirty list
+    std::atomic<bool> dirty;
+    OSThread *dirtyNext = NULL;
+
+    ThreadStats stats = {};
 
     /// Show debugging info for disabled threads
     static bool showDisabled;
@@ -42,10 +85,21 @@ class OSThread : public Thread
     static bool showWaiting;
 
   public:
-    /// For debug printing only (might be null)
+    /// For debug printing only (might be null, and always is on OS threads other than the main loop)
+#ifdef HAS_STD_THREADS
+    static thread_local const OSThread *currentThread;
+#else
     static const OSThread *currentThread;
+#endif
+
+    /// False on the extra OS threads a hosted build runs (e.g. the portduino packet pipeline), which must stay off main loop state
+#ifdef HAS_STD_THREADS
+    static bool isMainThread() { return std::this_thread::get_id() == mainThreadId; }
+#else
+    static bool isMainThread() { return true; }
+#endif
 
-    OSThread(const char *name, uint32_t period = 0, ThreadController *controller = &mainController);
+    OSThread(const char *name, uint32_t period = 0, DeadlineScheduler *controller = &mainController);
 
     virtual ~OSThread();
 
@@ -60,6 +114,24 @@ class OSThread : public Thread
      */
     void setIntervalFromNow(unsigned long _interval);
 
+    /// Like Thread::setInterval, but also lets our controller know our deadline moved
+    virtual void setInterval(unsigned long _interval);
+
+    /**
+     * Run on the controller's next pass regardless of our interval (if we are enabled).  Safe to call from an ISR or another OS
+     * thread, but the caller still needs to interrupt mainDelay if the main loop might be sleeping.
+     */
+    void wake();
+
+    const ThreadStats &getStats() const { return stats; }
+    void resetStats() { stats = {}; }
+
+    /// Upper bound (exclusive) of histogram bucket i in usecs, the last bucket has no upper bound
+    static uint32_t bucketLimitUsec(int i) { return 256UL << (2 * i); }
+
+    /// Log the stats of every thread on mainController, busiest first
+    static void logAllStats();
+
   protected:
     /**
      * The method that will be called each time our thread gets a chance to run
@@ -71,6 +143,14 @@ class OSThread : public Thread
 
     // Do not override this
     virtual void run();
+
+  private:
+    void recordRun(uint32_t usec, uint32_t startMsec);
+
+#ifdef HAS_STD_THREADS
+    /// Recorded by setup(), which runs on the main loop's thread
+    static std::thread::id mainThreadId;
+#endif
 };
 
 /**
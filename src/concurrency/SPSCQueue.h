@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+namespace concurrency
+{
+
+/**
+ * A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * Neither side ever blocks, push() fails when the queue is full and pop() fails when it is empty - callers decide how to
+ * wait.  N must be a power of two.
+ */
+template <class T, size_t N> class SPSCQueue
+{
+    static_assert(N && (N & (N - 1)) == 0, "SPSCQueue size must be a power of two");
+
+    T buf[N];
+
+    /// Next slot to read, only written by the consumer
+    std::atomic<size_t> head;
+
+    /// Next slot to write, only written by the producer
+    std::atomic<size_t> tail;
+
+  public:
+    SPSCQueue() : head(0), tail(0) {}
+
+    /// Producer side, returns false if the queue is full
+    bool push(const T &x)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N)
+            return false;
+        buf[t % N] = x;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side, returns false if the queue is empty
+    bool pop(T &x)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        x = buf[h % N];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    bool isFull() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire) == N; }
+};
+
+} // namespace concurrency
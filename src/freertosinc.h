@@ -44,4 +44,9 @@ typedef uint32_t BaseType_t;
 
 enum eNotifyAction { eNoAction, eSetValueWithoutOverwrite, eSetValueWithOverwrite };
 
+// Hosted builds (portduino) run on a real OS, so our locks and semaphores can be built on the C++ thread library
+#if defined(__linux__) || defined(__APPLE__)
+#define HAS_STD_THREADS
+#endif
+
 #endif
\ No newline at end of file
@@ -442,6 +442,7 @@ class Screen : public concurrency::OSThread
         else {
             bool success = cmdQueue.enqueue(cmd, 0);
             enabled = true; // handle ASAP (we are the registered reader for cmdQueue, but might have been disabled)
+            wake();
             return success;
         }
     }
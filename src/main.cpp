@@ -88,6 +88,8 @@ NRF52Bluetooth *nrf52Bluetooth = nullptr;
 #ifdef ARCH_PORTDUINO
 #include "linux/LinuxHardwareI2C.h"
 #include "mesh/raspihttp/PiWebServer.h"
+#include "platform/portduino/MappedNodeStore.h"
+#include "platform/portduino/PacketPipeline.h"
 #include "platform/portduino/PortduinoGlue.h"
 #include <fstream>
 #include <iostream>
@@ -596,6 +598,11 @@ void setup()
     rp2040Setup();
 #endif
 
+#ifdef ARCH_PORTDUINO
+    if (!settingsStrings[nodestore].empty())
+        mappedNodeStore = MappedNodeStore::open(settingsStrings[nodestore].c_str(), MAX_NUM_NODES);
+#endif
+
     // We do this as early as possible because this loads preferences from flash
     // but we need to do this after main cpu init (esp32setup), because we need the random seed set
     nodeDB = new NodeDB;
@@ -1005,6 +1012,8 @@ void setup()
     }
 #endif
     initApiServer(TCPPort);
+    if (settingsMap[pipelinemode])
+        packetPipeline = new PacketPipeline();
 #endif
 
     // Start airtime logger thread.
@@ -1063,6 +1072,9 @@ void loop()
 #endif
 #ifdef ARCH_NRF52
     nrf52Loop();
+#endif
+#ifdef ARCH_PORTDUINO
+    portduinoCheckSignals();
 #endif
     powerCommandsCheck();
 
@@ -1084,9 +1096,8 @@ void loop()
 
     long delayMsec = mainController.runOrDelay();
 
-    /* if (mainController.nextThread && delayMsec)
-        LOG_DEBUG("Next %s in %ld\n", mainController.nextThread->ThreadName.c_str(),
-                  mainController.nextThread->tillRun(millis())); */
+    /* if (delayMsec)
+        LOG_DEBUG("Next thread in %ld\n", delayMsec); */
 
     // We want to sleep as long as possible here - because it saves power
     if (!runASAP && loopCanSleep()) {
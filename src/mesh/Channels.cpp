@@ -197,17 +197,39 @@ CryptoKey Channels::getKey(ChannelIndex chIndex)
  */
 int16_t Channels::setCrypto(ChannelIndex chIndex)
 {
-    CryptoKey k = getKey(chIndex);
-
-    if (k.length < 0)
+    if (chIndex >= getNumChannels() || getHash(chIndex) < 0)
         return -1;
     else {
-        // Tell our crypto engine about the psk
-        crypto->setKey(k);
+        // Switch to the context rebuildCryptoCache() keyed with this channel's psk
+        crypto->useKeySlot(chIndex);
         return getHash(chIndex);
     }
 }
 
+void Channels::rebuildCryptoCache()
+{
+    static_assert(MAX_NUM_CHANNELS <= 8 && MAX_NUM_CHANNELS <= MAX_KEY_SLOTS, "one bit/key slot per channel");
+
+    // The portduino pipeline may be decoding on another thread (cryptLock doesn't exist yet during early boot)
+    if (cryptLock)
+        cryptLock->lock();
+
+    memset(channelsByHash, 0, sizeof(channelsByHash));
+    for (ChannelIndex i = 0; i < getNumChannels(); i++) {
+        // Recompute now that primaryIndex is final, secondary channels without a psk borrow the primary key
+        CryptoKey k = getKey(i);
+        hashes[i] = generateHash(i);
+        if (k.length < 0)
+            continue;
+
+        crypto->setKeySlot(i, k);
+        channelsByHash[(uint8_t)hashes[i]] |= (1 << i);
+    }
+
+    if (cryptLock)
+        cryptLock->unlock();
+}
+
 void Channels::initDefaults()
 {
     channelFile.channels_count = MAX_NUM_CHANNELS;
@@ -225,6 +247,7 @@ void Channels::onConfigChanged()
         if (ch.role == meshtastic_Channel_Role_PRIMARY)
             primaryIndex = i;
     }
+    rebuildCryptoCache();
 #if !MESHTASTIC_EXCLUDE_MQTT
     if (channels.anyMqttEnabled() && mqtt && !mqtt->isEnabled()) {
         LOG_DEBUG("MQTT is enabled on at least one channel, so set MQTT thread to run immediately\n");
@@ -342,7 +365,7 @@ bool Channels::hasDefaultChannel()
  */
 bool Channels::decryptForHash(ChannelIndex chIndex, ChannelHash channelHash)
 {
-    if (chIndex > getNumChannels() || getHash(chIndex) != channelHash) {
+    if (chIndex >= getNumChannels() || !(channelsByHash[channelHash] & (1 << chIndex))) {
         // LOG_DEBUG("Skipping channel %d (hash %x) due to invalid hash/index, want=%x\n", chIndex, getHash(chIndex),
         // channelHash);
         return false;
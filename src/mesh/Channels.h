@@ -28,6 +28,9 @@ class Channels
     /// the precomputed hashes for each of our channels, or -1 for invalid
     int16_t hashes[MAX_NUM_CHANNELS] = {};
 
+    /// For each possible channel hash, a bitmask of the channel indexes with that hash (bit N set means channel N)
+    uint8_t channelsByHash[256] = {};
+
   public:
     Channels() {}
 
@@ -75,6 +78,11 @@ class Channels
      */
     bool decryptForHash(ChannelIndex chIndex, ChannelHash channelHash);
 
+    /** Return a bitmask of the channel indexes whose hash matches channelHash, i.e. the only channels worth trying when
+     * decoding a packet with that hash.  Bit N set means channel N is a candidate.
+     */
+    uint8_t getChannelsForHash(ChannelHash channelHash) const { return channelsByHash[channelHash]; }
+
     /** Given a channel index setup crypto for encoding that channel (or the primary channel if that channel is unsecured)
      *
      * This method is called before encoding outbound packets
@@ -111,6 +119,11 @@ class Channels
 
     int16_t getHash(ChannelIndex i) { return hashes[i]; }
 
+    /** Give the crypto engine a pre-keyed context for every channel and rebuild channelsByHash, so that switching channels
+     * while decoding/encoding needs no key setup.  Called by onConfigChanged.
+     */
+    void rebuildCryptoCache();
+
     /**
      * Validate a channel, fixing any errors as needed
      */
@@ -7,6 +7,24 @@ void CryptoEngine::setKey(const CryptoKey &k)
 {
     LOG_DEBUG("Using AES%d key!\n", k.length * 8);
     key = k;
+    activeSlot = -1;
+}
+
+void CryptoEngine::setKeySlot(uint8_t slot, const CryptoKey &k)
+{
+    if (slot >= MAX_KEY_SLOTS)
+        return;
+    slotKeys[slot] = k;
+    if (activeSlot == slot)
+        activeSlot = -1; // force the next useKeySlot() to pick up the new key
+}
+
+void CryptoEngine::useKeySlot(uint8_t slot)
+{
+    if (slot >= MAX_KEY_SLOTS || slot == activeSlot)
+        return;
+    setKey(slotKeys[slot]);
+    activeSlot = slot;
 }
 
 /**
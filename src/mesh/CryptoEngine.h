@@ -19,6 +19,9 @@ struct CryptoKey {
 
 #define MAX_BLOCKSIZE 256
 
+/// Number of pre-keyed cipher contexts an engine keeps, one per channel index
+#define MAX_KEY_SLOTS 8
+
 class CryptoEngine
 {
   protected:
@@ -27,6 +30,12 @@ class CryptoEngine
 
     CryptoKey key = {};
 
+    /// Keys installed by setKeySlot()
+    CryptoKey slotKeys[MAX_KEY_SLOTS] = {};
+
+    /// The slot whose key is currently in use, or -1 if the key was set directly with setKey()
+    int8_t activeSlot = -1;
+
   public:
     virtual ~CryptoEngine() {}
 
@@ -41,6 +50,19 @@ class CryptoEngine
      */
     virtual void setKey(const CryptoKey &k);
 
+    /**
+     * Install the key for a cached context slot (we use one slot per channel index).  Engines that can keep several keyed
+     * contexts do their key expansion here, so that a later useKeySlot() costs nothing.
+     */
+    virtual void setKeySlot(uint8_t slot, const CryptoKey &k);
+
+    /**
+     * Select the key installed by setKeySlot() for subsequent encrypt/decrypt calls.
+     *
+     * The default implementation only calls setKey() when the slot differs from the active one.
+     */
+    virtual void useKeySlot(uint8_t slot);
+
     /**
      * Encrypt a packet
      *
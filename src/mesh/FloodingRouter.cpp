@@ -44,7 +44,10 @@ void FloodingRouter::sniffReceived(const meshtastic_MeshPacket *p, const meshtas
     if ((p->to != getNodeNum()) && (p->hop_limit > 0) && (getFrom(p) != getNodeNum())) {
         if (p->id != 0) {
             if (config.device.role != meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE) {
-                meshtastic_MeshPacket *tosend = packetPool.allocCopy(*p); // keep a copy because we will be sending it
+                // Prefer the bytes exactly as we received them, so Router::send doesn't have to encode and encrypt them again
+                const meshtastic_MeshPacket *original = getReceivedEncrypted(p);
+                meshtastic_MeshPacket *tosend =
+                    packetPool.allocCopy(original ? *original : *p); // keep a copy because we will be sending it
 
                 tosend->hop_limit--; // bump down the hop count
 #if EVENT_MODE
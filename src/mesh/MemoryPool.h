@@ -2,6 +2,8 @@
 
 #include <Arduino.h>
 #include <assert.h>
+#include <atomic>
+#include <type_traits>
 
 #include "PointerQueue.h"
 
@@ -46,6 +48,17 @@ template <class T> class Allocator
     /// Return a buffer for use by others
     virtual void release(T *p) = 0;
 
+    /**
+     * Return another reference to p, which must have come from this allocator.  Shared objects must be treated as read-only,
+     * call makeWritable() before changing one.  Each reference is given back with release().
+     * Allocators which don't count references just return a private copy.
+     */
+    virtual T *share(const T *p) { return allocCopy(*p); }
+
+    /// Copy-on-write: return p itself if the caller holds the only reference, otherwise drop the caller's reference and return a
+    /// private copy
+    virtual T *makeWritable(T *p) { return p; }
+
   protected:
     // Alloc some storage
     virtual T *alloc(TickType_t maxWait) = 0;
@@ -73,3 +86,157 @@ template <class T> class MemoryDynamic : public Allocator<T>
         return p;
     }
 };
+
+/// Occupancy counters reported by MemoryPool
+struct MemoryPoolStats {
+    uint32_t capacity;  // number of slots in the preallocated slab
+    uint32_t inUse;     // objects currently handed out (slab + heap overflow)
+    uint32_t highWater; // max value inUse has ever reached
+    uint32_t overflows; // number of allocations which had to fall back to the heap
+};
+
+/**
+ * A fixed capacity allocator backed by a statically allocated slab.
+ *
+ * Free slots are kept on a lock-free LIFO list (a Treiber stack whose head carries an ABA tag), so alloc and release from the
+ * slab never block and are safe to call from ISR code.  If the slab is exhausted and overflowToHeap is set, we fall back to
+ * malloc (which is NOT ISR safe) rather than failing, and count that event so the pool can be sized properly.
+ *
+ * Every object carries an intrusive reference count, so one buffer can be held by several queues at once (see share()).
+ */
+template <class T, int MaxSize> class MemoryPool : public Allocator<T>
+{
+    static_assert(MaxSize > 0 && MaxSize < 0xffff, "MemoryPool size must fit in a 16 bit slot index");
+
+    static const uint16_t NIL = 0xffff;
+
+    /// The object must stay the first member, we convert between T* and Slot* by casting
+    struct Slot {
+        T obj;
+        std::atomic<uint16_t> refs;
+    };
+    static_assert(std::is_standard_layout<Slot>::value, "MemoryPool slots must be standard layout");
+
+    Slot buf[MaxSize]; // our large raw block of memory
+
+    /// For each free slot, the index of the next free slot (or NIL)
+    std::atomic<uint16_t> nextFree[MaxSize];
+
+    /// Head of the free list, low 16 bits are the slot index, high 16 bits are a tag bumped on every pop to defeat ABA
+    std::atomic<uint32_t> freeHead;
+
+    const bool overflowToHeap;
+
+    std::atomic<uint32_t> inUse, highWater, overflows;
+
+  public:
+    explicit MemoryPool(bool _overflowToHeap = true)
+        : freeHead(0), overflowToHeap(_overflowToHeap), inUse(0), highWater(0), overflows(0)
+    {
+        for (int i = 0; i < MaxSize; i++)
+            nextFree[i].store(i + 1 < MaxSize ? i + 1 : NIL, std::memory_order_relaxed);
+    }
+
+    /// Return a buffer for use by others
+    virtual void release(T *p) override
+    {
+        assert(p);
+        Slot *slot = toSlot(p);
+        uint16_t oldRefs = slot->refs.fetch_sub(1, std::memory_order_acq_rel);
+        assert(oldRefs); // sanity check to catch double frees
+        if (oldRefs != 1)
+            return; // someone else still holds a reference
+
+        inUse.fetch_sub(1, std::memory_order_relaxed);
+
+        if (!isFromSlab(slot)) {
+            assert(overflowToHeap); // sanity check to make sure a programmer didn't free something that didn't come from us
+            free(slot);
+            return;
+        }
+
+        uint16_t index = slot - buf;
+        uint32_t head = freeHead.load(std::memory_order_relaxed);
+        uint32_t newHead;
+        do {
+            nextFree[index].store(head & 0xffff, std::memory_order_relaxed);
+            newHead = (head & 0xffff0000) | index;
+        } while (!freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    virtual T *share(const T *p) override
+    {
+        assert(p);
+        Slot *slot = toSlot(const_cast<T *>(p));
+        uint16_t oldRefs = slot->refs.fetch_add(1, std::memory_order_relaxed);
+        assert(oldRefs && oldRefs < UINT16_MAX); // the caller must already hold a reference
+        return &slot->obj;
+    }
+
+    virtual T *makeWritable(T *p) override
+    {
+        assert(p);
+        // If we hold the only reference nobody else can add one behind our back, so no need for anything fancier
+        if (toSlot(p)->refs.load(std::memory_order_acquire) == 1)
+            return p;
+
+        T *copy = this->allocCopy(*p);
+        release(p);
+        return copy;
+    }
+
+    MemoryPoolStats getStats() const
+    {
+        MemoryPoolStats s;
+        s.capacity = MaxSize;
+        s.inUse = inUse.load(std::memory_order_relaxed);
+        s.highWater = highWater.load(std::memory_order_relaxed);
+        s.overflows = overflows.load(std::memory_order_relaxed);
+        return s;
+    }
+
+  protected:
+    /// We never block waiting for a slot, maxWait is ignored
+    virtual T *alloc(TickType_t maxWait) override
+    {
+        Slot *slot = pop();
+
+        if (!slot && overflowToHeap) {
+            slot = (Slot *)malloc(sizeof(Slot));
+            if (slot)
+                overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (!slot)
+            return nullptr;
+
+        slot->refs.store(1, std::memory_order_relaxed);
+        uint32_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t high = highWater.load(std::memory_order_relaxed);
+        while (used > high && !highWater.compare_exchange_weak(high, used, std::memory_order_relaxed))
+            ;
+        return &slot->obj;
+    }
+
+  private:
+    static Slot *toSlot(T *p) { return reinterpret_cast<Slot *>(p); }
+
+    bool isFromSlab(const Slot *slot) const { return slot >= buf && slot < buf + MaxSize; }
+
+    /// Take a slot off the free list, or return nullptr if the slab is exhausted
+    Slot *pop()
+    {
+        uint32_t head = freeHead.load(std::memory_order_acquire);
+        uint32_t newHead;
+        uint16_t index;
+        do {
+            index = head & 0xffff;
+            if (index == NIL)
+                return nullptr;
+            uint32_t tag = (head >> 16) + 1;
+            newHead = (tag << 16) | nextFree[index].load(std::memory_order_relaxed);
+        } while (!freeHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire));
+
+        return &buf[index];
+    }
+};
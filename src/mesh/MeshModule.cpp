@@ -4,9 +4,13 @@
 #include "NodeDB.h"
 #include "configuration.h"
 #include "modules/RoutingModule.h"
+#include <algorithm>
 #include <assert.h>
 
 std::vector<MeshModule *> *MeshModule::modules;
+std::vector<std::pair<meshtastic_PortNum, MeshModule *>> *MeshModule::modulesByPort;
+std::vector<MeshModule *> *MeshModule::anyPortModules;
+std::vector<MeshModule *> *MeshModule::encryptedModules;
 
 const meshtastic_MeshPacket *MeshModule::currentRequest;
 
@@ -23,6 +27,14 @@ MeshModule::MeshModule(const char *_name) : name(_name)
         modules = new std::vector<MeshModule *>();
 
     modules->push_back(this);
+
+    // We can't ask a half constructed module what it wants, so just make callModules() rebuild the index
+    delete modulesByPort;
+    delete anyPortModules;
+    delete encryptedModules;
+    modulesByPort = NULL;
+    anyPortModules = NULL;
+    encryptedModules = NULL;
 }
 
 void MeshModule::setup() {}
@@ -72,6 +84,46 @@ meshtastic_MeshPacket *MeshModule::allocErrorResponse(meshtastic_Routing_Error e
     return r;
 }
 
+/// Orders modulesByPort entries by port only
+static bool portBefore(const std::pair<meshtastic_PortNum, MeshModule *> &a, const std::pair<meshtastic_PortNum, MeshModule *> &b)
+{
+    return a.first < b.first;
+}
+
+void MeshModule::buildDispatchIndex()
+{
+    modulesByPort = new std::vector<std::pair<meshtastic_PortNum, MeshModule *>>();
+    anyPortModules = new std::vector<MeshModule *>();
+    encryptedModules = new std::vector<MeshModule *>();
+
+    // Modules that may want every port (Routing, for one) go on one shared list instead of being copied under every port
+    std::vector<meshtastic_PortNum> wanted;
+    for (size_t i = 0; i < modules->size(); i++) {
+        MeshModule *pi = (*modules)[i];
+        pi->registrationIndex = i;
+        if (pi->encryptedOk)
+            encryptedModules->push_back(pi);
+
+        wanted.clear();
+        for (int port = meshtastic_PortNum_UNKNOWN_APP; port <= meshtastic_PortNum_MAX; port++)
+            if (pi->mayWantPortNum((meshtastic_PortNum)port))
+                wanted.push_back((meshtastic_PortNum)port);
+
+        if (wanted.size() == _meshtastic_PortNum_ARRAYSIZE)
+            anyPortModules->push_back(pi);
+        else
+            for (auto port : wanted)
+                modulesByPort->push_back(std::make_pair(port, pi));
+    }
+
+    // Stable, so each port's modules stay in registration order, which decides who gets to reply
+    std::stable_sort(modulesByPort->begin(), modulesByPort->end(), portBefore);
+    modulesByPort->shrink_to_fit();
+
+    LOG_DEBUG("Module dispatch index: %u port entries, %u modules for any port, %u for encrypted packets\n",
+              modulesByPort->size(), anyPortModules->size(), encryptedModules->size());
+}
+
 void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
 {
     // LOG_DEBUG("In call modules\n");
@@ -88,8 +140,30 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
     auto ourNodeNum = nodeDB->getNodeNum();
     bool toUs = mp.to == NODENUM_BROADCAST || mp.to == ourNodeNum;
 
-    for (auto i = modules->begin(); i != modules->end(); ++i) {
-        auto &pi = **i;
+    if (!modulesByPort)
+        buildDispatchIndex();
+
+    // Only visit the modules that could possibly want this packet: the ones that asked for its port merged, in registration
+    // order, with the ones that might want any port
+    const std::vector<MeshModule *> *shared = encryptedModules;
+    auto portBegin = modulesByPort->end(), portEnd = modulesByPort->end();
+    if (isDecoded) {
+        shared = anyPortModules;
+        auto range = std::equal_range(modulesByPort->begin(), modulesByPort->end(),
+                                      std::make_pair(mp.decoded.portnum, (MeshModule *)NULL), portBefore);
+        portBegin = range.first;
+        portEnd = range.second;
+    }
+    auto sharedNext = shared->begin();
+
+    while (portBegin != portEnd || sharedNext != shared->end()) {
+        MeshModule *next;
+        if (portBegin != portEnd &&
+            (sharedNext == shared->end() || portBegin->second->registrationIndex < (*sharedNext)->registrationIndex))
+            next = (portBegin++)->second;
+        else
+            next = *(sharedNext++);
+        auto &pi = *next;
 
         pi.currentRequest = &mp;
 
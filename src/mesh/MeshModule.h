@@ -2,6 +2,7 @@
 
 #include "mesh/Channels.h"
 #include "mesh/MeshTypes.h"
+#include <utility>
 #include <vector>
 
 #if HAS_SCREEN
@@ -60,6 +61,21 @@ class MeshModule
 {
     static std::vector<MeshModule *> *modules;
 
+    /// (portnum, module) for every port each module asks for specifically, sorted by port and then registration order.  Built
+    /// on first use by callModules() and thrown away whenever a module is added.
+    static std::vector<std::pair<meshtastic_PortNum, MeshModule *>> *modulesByPort;
+
+    /// Modules that might want any portnum, callModules() merges them (by registration order) with the modules for the port
+    static std::vector<MeshModule *> *anyPortModules;
+
+    /// Modules with encryptedOk set, the only ones that can see a packet we could not decode
+    static std::vector<MeshModule *> *encryptedModules;
+
+    static void buildDispatchIndex();
+
+    /// Our position in modules, so callModules() can merge the dispatch lists back into registration order
+    uint16_t registrationIndex = 0;
+
   public:
     /** Constructor
      * name is for debugging output
@@ -134,6 +150,14 @@ class MeshModule
      */
     virtual bool wantPacket(const meshtastic_MeshPacket *p) = 0;
 
+    /**
+     * Used once, to build the callModules() dispatch index: return false for any portnum wantPacket() could never return true
+     * for, so we don't even get asked.  Modules that override wantPacket() to look at more than their own port must override
+     * this too.  isPromiscuous, loopbackOk and encryptedOk are still checked on every packet, but encryptedOk is also read
+     * when the index is built.
+     */
+    virtual bool mayWantPortNum(meshtastic_PortNum portnum) { return true; }
+
     /** Called to handle a particular incoming message
 
     @return ProcessMessage::STOP if you've guaranteed you've handled this message and no other handlers should be considered for
@@ -1,34 +1,54 @@
 #include "MeshPacketQueue.h"
 #include "configuration.h"
 #include <assert.h>
-
-#include <algorithm>
+#include <string.h>
 
 /// @return the priority of the specified packet
-inline uint32_t getPriority(const meshtastic_MeshPacket *p)
+inline uint8_t getPriority(const meshtastic_MeshPacket *p)
 {
     auto pri = p->priority;
-    return pri;
+    return pri > meshtastic_MeshPacket_Priority_MAX ? meshtastic_MeshPacket_Priority_MAX : pri;
 }
 
-/// @return "true" if "p1" is ordered before "p2"
-bool CompareMeshPacketFunc(const meshtastic_MeshPacket *p1, const meshtastic_MeshPacket *p2)
+MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen), entries(_maxLen)
 {
-    assert(p1 && p2);
-    auto p1p = getPriority(p1), p2p = getPriority(p2);
-
-    // If priorities differ, use that
-    // for equal priorities, order by id (older packets have higher priority - this will briefly be wrong when IDs roll over but
-    // no big deal)
-    return (p1p != p2p) ? (p1p < p2p)         // prefer bigger priorities
-                        : (p1->id >= p2->id); // prefer smaller packet ids
+    assert(maxLen < NIL); // entries are referenced by 8 bit indexes
+
+    // Thread all the entries onto the free list
+    for (size_t i = 0; i < maxLen; i++)
+        entries[i].next = (i + 1 < maxLen) ? i + 1 : NIL;
+    freeList = maxLen ? 0 : NIL;
+
+    memset(bucketHead, NIL, sizeof(bucketHead));
+    memset(bucketTail, NIL, sizeof(bucketTail));
+    memset(occupied, 0, sizeof(occupied));
+
+    // Keep the index at most half full so chains stay short
+    size_t indexSize = 1;
+    while (indexSize < 2 * maxLen)
+        indexSize <<= 1;
+    index.assign(indexSize, (uint8_t)NIL);
 }
 
-MeshPacketQueue::MeshPacketQueue(size_t _maxLen) : maxLen(_maxLen) {}
-
 bool MeshPacketQueue::empty()
 {
-    return queue.empty();
+    return numQueued == 0;
+}
+
+int MeshPacketQueue::highestBucket() const
+{
+    for (int w = NUM_PRIORITIES / 32 - 1; w >= 0; w--)
+        if (occupied[w])
+            return w * 32 + 31 - __builtin_clz(occupied[w]);
+    return -1;
+}
+
+int MeshPacketQueue::lowestBucket() const
+{
+    for (int w = 0; w < NUM_PRIORITIES / 32; w++)
+        if (occupied[w])
+            return w * 32 + __builtin_ctz(occupied[w]);
+    return -1;
 }
 
 /**
@@ -53,47 +73,95 @@ bool MeshPacketQueue::enqueue(meshtastic_MeshPacket *p)
     fixPriority(p);
 
     // no space - try to replace a lower priority packet in the queue
-    if (queue.size() >= maxLen) {
+    if (numQueued >= maxLen) {
         return replaceLowerPriorityPacket(p);
     }
 
-    queue.push_back(p);
-    std::push_heap(queue.begin(), queue.end(), &CompareMeshPacketFunc);
+    uint8_t e = freeList;
+    assert(e != NIL);
+    Entry &entry = entries[e];
+    freeList = entry.next;
+
+    entry.packet = p;
+    entry.from = getFrom(p);
+    entry.priority = getPriority(p);
+
+    // Append to the tail of our bucket, so packets of equal priority go out in the order they were queued
+    entry.prev = bucketTail[entry.priority];
+    entry.next = NIL;
+    if (entry.prev != NIL)
+        entries[entry.prev].next = e;
+    else
+        bucketHead[entry.priority] = e;
+    bucketTail[entry.priority] = e;
+    occupied[entry.priority / 32] |= 1u << (entry.priority % 32);
+
+    size_t h = hashOf(entry.from, p->id);
+    entry.hashNext = index[h];
+    index[h] = e;
+
+    numQueued++;
     return true;
 }
 
-meshtastic_MeshPacket *MeshPacketQueue::dequeue()
+meshtastic_MeshPacket *MeshPacketQueue::unlink(uint8_t e)
 {
-    if (empty()) {
-        return NULL;
+    Entry &entry = entries[e];
+
+    if (entry.prev != NIL)
+        entries[entry.prev].next = entry.next;
+    else
+        bucketHead[entry.priority] = entry.next;
+    if (entry.next != NIL)
+        entries[entry.next].prev = entry.prev;
+    else
+        bucketTail[entry.priority] = entry.prev;
+    if (bucketHead[entry.priority] == NIL)
+        occupied[entry.priority / 32] &= ~(1u << (entry.priority % 32));
+
+    // Chains are only a couple of entries long, so just walk ours to find who points at us
+    uint8_t *link = &index[hashOf(entry.from, entry.packet->id)];
+    while (*link != e) {
+        assert(*link != NIL);
+        link = &entries[*link].hashNext;
     }
+    *link = entry.hashNext;
 
-    auto *p = queue.front();
-    std::pop_heap(queue.begin(), queue.end(), &CompareMeshPacketFunc);
-    queue.pop_back();
+    entry.next = freeList;
+    freeList = e;
+    numQueued--;
 
+    auto p = entry.packet;
+    entry.packet = NULL;
     return p;
 }
 
+meshtastic_MeshPacket *MeshPacketQueue::dequeue()
+{
+    int b = highestBucket();
+    if (b < 0) {
+        return NULL;
+    }
+
+    return unlink(bucketHead[b]);
+}
+
 meshtastic_MeshPacket *MeshPacketQueue::getFront()
 {
-    if (empty()) {
+    int b = highestBucket();
+    if (b < 0) {
         return NULL;
     }
 
-    auto *p = queue.front();
-    return p;
+    return entries[bucketHead[b]].packet;
 }
 
 /** Attempt to find and remove a packet from this queue.  Returns a pointer to the removed packet, or NULL if not found */
 meshtastic_MeshPacket *MeshPacketQueue::remove(NodeNum from, PacketId id)
 {
-    for (auto it = queue.begin(); it != queue.end(); it++) {
-        auto p = (*it);
-        if (getFrom(p) == from && p->id == id) {
-            queue.erase(it);
-            std::make_heap(queue.begin(), queue.end(), &CompareMeshPacketFunc);
-            return p;
+    for (uint8_t e = index[hashOf(from, id)]; e != NIL; e = entries[e].hashNext) {
+        if (entries[e].from == from && entries[e].packet->id == id) {
+            return unlink(e);
         }
     }
 
@@ -103,28 +171,14 @@ meshtastic_MeshPacket *MeshPacketQueue::remove(NodeNum from, PacketId id)
 /** Attempt to find and remove a packet from this queue.  Returns the packet which was removed from the queue */
 bool MeshPacketQueue::replaceLowerPriorityPacket(meshtastic_MeshPacket *p)
 {
-    std::sort_heap(queue.begin(), queue.end(), &CompareMeshPacketFunc); // sort ascending based on priority (0 -> 127)
+    int low = lowestBucket();
 
-    // find first packet which does not compare less (in priority) than parameter packet
-    auto low = std::lower_bound(queue.begin(), queue.end(), p, &CompareMeshPacketFunc);
-
-    if (low == queue.begin()) { // if already at start, there are no packets with lower priority
+    if (low < 0 || low >= getPriority(p)) { // there are no packets with lower priority
         return false;
     }
 
-    if (low == queue.end()) {
-        // all priorities in the vector are smaller than the incoming packet. Replace the lowest priority (first) element
-        low = queue.begin();
-    } else {
-        // 'low' iterator points to first packet which does not compare less than parameter
-        --low; // iterate to lower priority packet
-    }
+    // Drop the newest of the lowest priority packets, the older ones have been waiting longer
+    packetPool.release(unlink(bucketTail[low])); // deallocate and drop the packet we're replacing
 
-    if (getPriority(p) > getPriority(*low)) {
-        packetPool.release(*low); // deallocate and drop the packet we're replacing
-        *low = p;                 // replace low-pri packet at this position with incoming packet with higher priority
-    }
-
-    std::make_heap(queue.begin(), queue.end(), &CompareMeshPacketFunc);
-    return true;
+    return enqueue(p);
 }
@@ -2,20 +2,54 @@
 
 #include "MeshTypes.h"
 
-#include <queue>
+#include <vector>
 
 /**
  * A priority queue of packets
+ *
+ * Packets are kept in one FIFO bucket per priority level, with a bitmap of non empty buckets, plus a (from, id) hash index.
+ * So enqueue, dequeue, remove (cancel) and dropping the lowest priority packet are all O(1).
  */
 class MeshPacketQueue
 {
+    static const uint8_t NIL = 0xff;
+    static const int NUM_PRIORITIES = meshtastic_MeshPacket_Priority_MAX + 1;
+
+    struct Entry {
+        meshtastic_MeshPacket *packet;
+        NodeNum from;     // getFrom(packet) at the time it was queued
+        uint8_t priority; // bucket we are in
+        uint8_t prev;     // neighbours in our priority bucket, next is also used for the free list
+        uint8_t next;
+        uint8_t hashNext; // next entry in the same index chain
+    };
+
     size_t maxLen;
-    std::vector<meshtastic_MeshPacket *> queue;
+    size_t numQueued = 0;
+
+    std::vector<Entry> entries;
+    uint8_t freeList = NIL;
+
+    uint8_t bucketHead[NUM_PRIORITIES];
+    uint8_t bucketTail[NUM_PRIORITIES];
+    uint32_t occupied[NUM_PRIORITIES / 32]; // bitmap of non empty buckets
+
+    /// (from, id) hash -> first entry of that chain
+    std::vector<uint8_t> index;
 
     /** Replace a lower priority package in the queue with 'mp' (provided there are lower pri packages). Return true if replaced.
      */
     bool replaceLowerPriorityPacket(meshtastic_MeshPacket *mp);
 
+    size_t hashOf(NodeNum from, PacketId id) const { return ((from * 0x9E3779B1u) ^ id) & (index.size() - 1); }
+
+    /// @return the highest/lowest priority bucket which has packets in it, or -1 if we are empty
+    int highestBucket() const;
+    int lowestBucket() const;
+
+    /// Take entry e out of its bucket and the index and put it on the free list, returns the packet it held
+    meshtastic_MeshPacket *unlink(uint8_t e);
+
   public:
     explicit MeshPacketQueue(size_t _maxLen);
 
@@ -26,7 +60,7 @@ class MeshPacketQueue
     bool empty();
 
     /** return amount of free packets in Queue */
-    size_t getFree() { return maxLen - queue.size(); }
+    size_t getFree() { return maxLen - numQueued; }
 
     /** return total size of the Queue */
     size_t getMaxLen() { return maxLen; }
@@ -4,6 +4,7 @@
 #include "GPS.h"
 #endif
 
+#include "../concurrency/LockGuard.h"
 #include "../concurrency/Periodic.h"
 #include "BluetoothCommon.h" // needed for updateBatteryLevel, FIXME, eventually when we pull mesh out into a lib we shouldn't be whacking bluetooth from here
 #include "MeshService.h"
@@ -66,7 +67,7 @@ Allocator<meshtastic_QueueStatus> &queueStatusPool = staticQueueStatusPool;
 #include "Router.h"
 
 MeshService::MeshService()
-    : toPhoneQueue(MAX_RX_TOPHONE), toPhoneQueueStatusQueue(MAX_RX_TOPHONE), toPhoneMqttProxyQueue(MAX_RX_TOPHONE)
+    : toPhoneQueueStatusQueue(MAX_RX_TOPHONE), toPhoneMqttProxyQueue(MAX_RX_TOPHONE)
 {
     lastQueueStatus = {0, 0, 16, 0};
 }
@@ -102,7 +103,7 @@ int MeshService::handleFromRadio(const meshtastic_MeshPacket *mp)
     }
 
     printPacket("Forwarding to phone", mp);
-    sendToPhone(packetPool.allocCopy(*mp));
+    sendToPhone(packetPool.share(mp));
 
     return 0;
 }
@@ -131,7 +132,7 @@ bool MeshService::reloadConfig(int saveWhat)
     bool didReset = nodeDB->resetRadioConfig(); // Don't let the phone send us fatally bad settings
 
     configChanged.notifyObservers(NULL); // This will cause radio hardware to change freqs etc
-    nodeDB->saveToDisk(saveWhat);
+    nodeDB->saveToDiskLater(saveWhat); // Admin changes tend to come in bursts, write them out once they stop
 
     return didReset;
 }
@@ -149,20 +150,44 @@ void MeshService::reloadOwner(bool shouldSave)
     }
 }
 
-// search the queue for a request id and return the matching nodenum
 NodeNum MeshService::getNodenumFromRequestId(uint32_t request_id)
 {
-    NodeNum nodenum = 0;
-    for (int i = 0; i < toPhoneQueue.numUsed(); i++) {
-        meshtastic_MeshPacket *p = toPhoneQueue.dequeuePtr(0);
-        if (p->id == request_id) {
-            nodenum = p->to;
-            // make sure to continue this to make one full loop
+    concurrency::LockGuard guard(&requestLock);
+    auto it = outstandingRequests.find(request_id);
+    if (it == outstandingRequests.end() || millis() - it->second.sentMsec >= REQUEST_ID_TIMEOUT_MSEC)
+        return 0;
+    return it->second.to;
+}
+
+void MeshService::forgetRequest(uint32_t request_id)
+{
+    concurrency::LockGuard guard(&requestLock);
+    outstandingRequests.erase(request_id);
+}
+
+void MeshService::rememberRequest(const meshtastic_MeshPacket &p)
+{
+    if (!p.id)
+        return; // no ACK/NAK could refer to it
+
+    concurrency::LockGuard guard(&requestLock);
+    uint32_t now = millis();
+    if (outstandingRequests.size() >= MAX_OUTSTANDING_REQUESTS && !outstandingRequests.count(p.id)) {
+        // Make room, first by dropping everything that timed out, and failing that the oldest
+        auto oldest = outstandingRequests.end();
+        for (auto it = outstandingRequests.begin(); it != outstandingRequests.end();) {
+            if (now - it->second.sentMsec >= REQUEST_ID_TIMEOUT_MSEC) {
+                it = outstandingRequests.erase(it);
+            } else {
+                if (oldest == outstandingRequests.end() || now - it->second.sentMsec > now - oldest->second.sentMsec)
+                    oldest = it;
+                ++it;
+            }
         }
-        // put it right back on the queue
-        toPhoneQueue.enqueue(p, 0);
+        if (outstandingRequests.size() >= MAX_OUTSTANDING_REQUESTS)
+            outstandingRequests.erase(oldest);
     }
-    return nodenum;
+    outstandingRequests[p.id] = {p.to, now};
 }
 
 /**
@@ -210,9 +235,10 @@ void MeshService::handleToRadio(meshtastic_MeshPacket &p)
 
     bool loopback = false; // if true send any packet the phone sends back itself (for testing)
     if (loopback) {
-        // no need to copy anymore because handle from radio assumes it should _not_ delete
-        // packetPool.allocCopy(r.variant.packet);
-        handleFromRadio(&p);
+        // handleFromRadio does not delete the packet, but it may share it so it must come from the pool
+        meshtastic_MeshPacket *copy = packetPool.allocCopy(p);
+        handleFromRadio(copy);
+        packetPool.release(copy);
         // handleFromRadio will tell the phone a new packet arrived
     }
 }
@@ -249,6 +275,7 @@ void MeshService::sendToMesh(meshtastic_MeshPacket *p, RxSource src, bool ccToPh
 {
     uint32_t mesh_packet_id = p->id;
     nodeDB->updateFrom(*p); // update our local DB for this packet (because phone might have sent position packets etc...)
+    rememberRequest(*p);    // before sendLocal(), which might release p
 
     // Note: We might return !OK if our fifo was full, at that point the only option we have is to drop it
     ErrorCode res = router->sendLocal(p, src);
@@ -268,7 +295,7 @@ void MeshService::sendToMesh(meshtastic_MeshPacket *p, RxSource src, bool ccToPh
 
 bool MeshService::trySendPosition(NodeNum dest, bool wantReplies)
 {
-    meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(nodeDB->getNodeNum());
+    const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(nodeDB->getNodeNum());
 
     assert(node);
 
@@ -291,7 +318,10 @@ bool MeshService::trySendPosition(NodeNum dest, bool wantReplies)
 
 void MeshService::sendToPhone(meshtastic_MeshPacket *p)
 {
-    perhapsDecode(p);
+    if (p->which_payload_variant != meshtastic_MeshPacket_decoded_tag) {
+        p = packetPool.makeWritable(p); // decoding happens in place
+        perhapsDecode(p);
+    }
 
 #ifdef ARCH_ESP32
 #if !MESHTASTIC_EXCLUDE_STOREFORWARD
@@ -304,22 +334,7 @@ void MeshService::sendToPhone(meshtastic_MeshPacket *p)
 #endif
 #endif
 
-    if (toPhoneQueue.numFree() == 0) {
-        if (p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP ||
-            p->decoded.portnum == meshtastic_PortNum_RANGE_TEST_APP) {
-            LOG_WARN("ToPhone queue is full, discarding oldest\n");
-            meshtastic_MeshPacket *d = toPhoneQueue.dequeuePtr(0);
-            if (d)
-                releaseToPool(d);
-        } else {
-            LOG_WARN("ToPhone queue is full, dropping packet.\n");
-            releaseToPool(p);
-            fromNum++; // Make sure to notify observers in case they are reconnected so they can get the packets
-            return;
-        }
-    }
-
-    assert(toPhoneQueue.enqueue(p, 0));
+    toPhoneRing.push(p); // drops the oldest packet if full
     fromNum++;
 }
 
@@ -351,8 +366,8 @@ meshtastic_NodeInfoLite *MeshService::refreshLocalMeshNode()
     meshtastic_PositionLite &position = node->position;
 
     // Update our local node info with our time (even if we don't decide to update anyone else)
-    node->last_heard =
-        getValidTime(RTCQualityFromNet); // This nodedb timestamp might be stale, so update it if our clock is kinda valid
+    // This nodedb timestamp might be stale, so update it if our clock is kinda valid
+    nodeDB->setLastHeard(node, getValidTime(RTCQualityFromNet), node->via_mqtt);
 
     position.time = getValidTime(RTCQualityFromNet);
 
@@ -400,5 +415,5 @@ int MeshService::onGPSChanged(const meshtastic::GPSStatus *newStatus)
 #endif
 bool MeshService::isToPhoneQueueEmpty()
 {
-    return toPhoneQueue.isEmpty();
+    return toPhoneRing.allDelivered();
 }
\ No newline at end of file
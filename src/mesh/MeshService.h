@@ -3,6 +3,7 @@
 #include <Arduino.h>
 #include <assert.h>
 #include <string>
+#include <unordered_map>
 
 #include "GPSStatus.h"
 #include "MemoryPool.h"
@@ -10,6 +11,7 @@
 #include "MeshTypes.h"
 #include "Observer.h"
 #include "PointerQueue.h"
+#include "ToPhoneRing.h"
 #if defined(ARCH_PORTDUINO) && !HAS_RADIO
 #include "../platform/portduino/SimRadio.h"
 #endif
@@ -19,6 +21,16 @@
 #endif
 #endif
 
+// How many packets we remember the destination of, while we wait for their ACK/NAK
+#ifndef MAX_OUTSTANDING_REQUESTS
+#define MAX_OUTSTANDING_REQUESTS MAX_RX_TOPHONE
+#endif
+
+// Forget a request's destination if no ACK/NAK has shown up after this long (longer than ReliableRouter keeps retrying)
+#ifndef REQUEST_ID_TIMEOUT_MSEC
+#define REQUEST_ID_TIMEOUT_MSEC (5 * 60 * 1000)
+#endif
+
 extern Allocator<meshtastic_QueueStatus> &queueStatusPool;
 extern Allocator<meshtastic_MqttClientProxyMessage> &mqttClientProxyMessagePool;
 
@@ -32,11 +44,9 @@ class MeshService
     CallbackObserver<MeshService, const meshtastic::GPSStatus *> gpsObserver =
         CallbackObserver<MeshService, const meshtastic::GPSStatus *>(this, &MeshService::onGPSChanged);
 #endif
-    /// received packets waiting for the phone to process them
-    /// FIXME, change to a DropOldestQueue and keep a count of the number of dropped packets to ensure
-    /// we never hang because android hasn't been there in a while
+    /// received packets waiting for the phone(s) to process them
     /// FIXME - save this to flash on deep sleep
-    PointerQueue<meshtastic_MeshPacket> toPhoneQueue;
+    ToPhoneRing toPhoneRing;
 
     // keep list of QueueStatus packets to be send to the phone
     PointerQueue<meshtastic_QueueStatus> toPhoneQueueStatusQueue;
@@ -53,6 +63,17 @@ class MeshService
     /// Updated in loop() to detect when fromNum changes
     uint32_t oldFromNum = 0;
 
+    struct OutstandingRequest {
+        NodeNum to;
+        uint32_t sentMsec;
+    };
+
+    /// Destinations of the packets we sent, by packet id, until their ACK/NAK arrives or they time out
+    std::unordered_map<PacketId, OutstandingRequest> outstandingRequests;
+
+    /// sendToMesh() can be called from the BLE task
+    concurrency::Lock requestLock;
+
   public:
     static bool isTextPayload(const meshtastic_MeshPacket *p)
     {
@@ -62,6 +83,13 @@ class MeshService
         return p->decoded.portnum == meshtastic_PortNum_TEXT_MESSAGE_APP ||
                p->decoded.portnum == meshtastic_PortNum_DETECTION_SENSOR_APP;
     }
+
+    /// True for every portnum isTextPayload() might accept, whatever the current config
+    static bool isTextPortNum(meshtastic_PortNum portnum)
+    {
+        return portnum == meshtastic_PortNum_TEXT_MESSAGE_APP || portnum == meshtastic_PortNum_DETECTION_SENSOR_APP ||
+               portnum == meshtastic_PortNum_RANGE_TEST_APP;
+    }
     /// Called when some new packets have arrived from one of the radios
     Observable<uint32_t> fromNumChanged;
 
@@ -75,9 +103,14 @@ class MeshService
     /// Do idle processing (mostly processing messages which have been queued from the radio)
     void loop();
 
-    /// Return the next packet destined to the phone.  FIXME, somehow use fromNum to allow the phone to retry the
-    /// last few packets if needs to.
-    meshtastic_MeshPacket *getForPhone() { return toPhoneQueue.dequeuePtr(0); }
+    /// Start (or resume) a phone client's reads of the packets destined to the phone
+    void attachPhone(ToPhoneRing::Cursor &c) { toPhoneRing.attach(c); }
+
+    /// Return the next packet destined to the phone with this cursor, which must release it with releaseToPool()
+    meshtastic_MeshPacket *getForPhone(ToPhoneRing::Cursor &c) { return toPhoneRing.take(c); }
+
+    /// Packets that were dropped before any phone read them
+    uint32_t getToPhoneDropped() const { return toPhoneRing.getDropped(); }
 
     /// Allows the bluetooth handler to free packets after they have been sent
     void releaseToPool(meshtastic_MeshPacket *p) { packetPool.release(p); }
@@ -88,9 +121,12 @@ class MeshService
     /// Return the next MqttClientProxyMessage packet destined to the phone.
     meshtastic_MqttClientProxyMessage *getMqttClientProxyMessageForPhone() { return toPhoneMqttProxyQueue.dequeuePtr(0); }
 
-    // search the queue for a request id and return the matching nodenum
+    /// Return where the packet with this id (that we sent) was going, or 0 if we don't know
     NodeNum getNodenumFromRequestId(uint32_t request_id);
 
+    /// The ACK/NAK for this packet id has been handled, so we no longer need its destination
+    void forgetRequest(uint32_t request_id);
+
     // Release QueueStatus packet to pool
     void releaseQueueStatusToPool(meshtastic_QueueStatus *p) { queueStatusPool.release(p); }
 
@@ -128,7 +164,7 @@ class MeshService
     /// Pull the latest power and time info into my nodeinfo
     meshtastic_NodeInfoLite *refreshLocalMeshNode();
 
-    /// Send a packet to the phone
+    /// Send a packet to the phone - note p may be a shared reference (see Allocator::share), we never modify it
     void sendToPhone(meshtastic_MeshPacket *p);
 
     /// Send an MQTT message to the phone for client proxying
@@ -139,13 +175,16 @@ class MeshService
     ErrorCode sendQueueStatusToPhone(const meshtastic_QueueStatus &qs, ErrorCode res, uint32_t mesh_packet_id);
 
   private:
+    /// Note p's destination for getNodenumFromRequestId()
+    void rememberRequest(const meshtastic_MeshPacket &p);
+
 #if HAS_GPS
     /// Called when our gps position has changed - updates nodedb and sends Location message out into the mesh
     /// returns 0 to allow further processing
     int onGPSChanged(const meshtastic::GPSStatus *arg);
 #endif
     /// Handle a packet that just arrived from the radio.  This method does _not_ free the provided packet.  If it
-    /// needs to keep the packet around it makes a copy
+    /// needs to keep the packet around it takes a shared reference, so p must have come from packetPool
     int handleFromRadio(const meshtastic_MeshPacket *p);
     friend class RoutingModule;
 };
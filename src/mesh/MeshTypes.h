@@ -43,6 +43,9 @@ typedef int ErrorCode;
 /// Alloc and free packets to our global, ISR safe pool
 extern Allocator<meshtastic_MeshPacket> &packetPool;
 
+/// Occupancy counters of packetPool, for diagnostics
+MemoryPoolStats getPacketPoolStats();
+
 /**
  * Most (but not always) of the time we want to treat packets 'from' the local phone (where from == 0), as if they originated on
  * the local node. If from is zero this function returns our node number instead
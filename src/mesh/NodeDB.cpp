@@ -15,6 +15,7 @@
 #include "RTC.h"
 #include "Router.h"
 #include "TypeConversions.h"
+#include "concurrency/Periodic.h"
 #include "error.h"
 #include "main.h"
 #include "mesh-pb-constants.h"
@@ -36,6 +37,7 @@
 #endif
 
 #ifdef ARCH_PORTDUINO
+#include "platform/portduino/MappedNodeStore.h"
 #include "platform/portduino/PortduinoGlue.h"
 #endif
 
@@ -466,26 +468,33 @@ void NodeDB::resetNodes()
 {
     clearLocalPosition();
     numMeshNodes = 1;
-    std::fill(devicestate.node_db_lite.begin() + 1, devicestate.node_db_lite.end(), meshtastic_NodeInfoLite());
+    std::fill(meshNodes.base + 1, meshNodes.base + meshNodes.size(), meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     saveDeviceStateToDisk();
     if (neighborInfoModule && moduleConfig.neighbor_info.enabled)
         neighborInfoModule->resetNeighbors();
 }
 
 void NodeDB::removeNodeByNum(NodeNum nodeNum)
+{
+    int removed = purgeNode(nodeNum);
+    LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Saving changes...\n", removed);
+    saveDeviceStateToDisk();
+}
+
+int NodeDB::purgeNode(NodeNum nodeNum)
 {
     int newPos = 0, removed = 0;
     for (int i = 0; i < numMeshNodes; i++) {
-        if (meshNodes->at(i).num != nodeNum)
-            meshNodes->at(newPos++) = meshNodes->at(i);
+        if (meshNodes.at(i).num != nodeNum)
+            meshNodes.at(newPos++) = meshNodes.at(i);
         else
             removed++;
     }
     numMeshNodes -= removed;
-    std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + 1,
-              meshtastic_NodeInfoLite());
-    LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Saving changes...\n", removed);
-    saveDeviceStateToDisk();
+    std::fill(meshNodes.base + numMeshNodes, meshNodes.base + numMeshNodes + 1, meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
+    return removed;
 }
 
 void NodeDB::clearLocalPosition()
@@ -502,14 +511,14 @@ void NodeDB::cleanupMeshDB()
 {
     int newPos = 0, removed = 0;
     for (int i = 0; i < numMeshNodes; i++) {
-        if (meshNodes->at(i).has_user)
-            meshNodes->at(newPos++) = meshNodes->at(i);
+        if (meshNodes.at(i).has_user)
+            meshNodes.at(newPos++) = meshNodes.at(i);
         else
             removed++;
     }
     numMeshNodes -= removed;
-    std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + removed,
-              meshtastic_NodeInfoLite());
+    std::fill(meshNodes.base + numMeshNodes, meshNodes.base + numMeshNodes + removed, meshtastic_NodeInfoLite());
+    rebuildNodeIndex();
     LOG_DEBUG("cleanupMeshDB purged %d entries\n", removed);
 }
 
@@ -519,7 +528,8 @@ void NodeDB::installDefaultDeviceState()
     // memset(&devicestate, 0, sizeof(meshtastic_DeviceState));
 
     numMeshNodes = 0;
-    meshNodes = &devicestate.node_db_lite;
+    attachNodeRecords();
+    rebuildNodeIndex();
 
     // init our devicestate with valid flags so protobuf writing/reading will work
     devicestate.has_my_node = true;
@@ -567,6 +577,7 @@ void NodeDB::pickNewNodeNum()
 
 static const char *prefFileName = "/prefs/db.proto";
 static const char *configFileName = "/prefs/config.proto";
+static const char *nodeJournalFileName = "/prefs/nodes.log";
 static const char *moduleConfigFileName = "/prefs/module.proto";
 static const char *channelFileName = "/prefs/channels.proto";
 static const char *oemConfigFile = "/oem/oem.proto";
@@ -614,6 +625,7 @@ void NodeDB::loadFromDisk()
     auto state = loadProto(prefFileName, sizeof(meshtastic_DeviceState) + MAX_NUM_NODES * sizeof(meshtastic_NodeInfo),
                            sizeof(meshtastic_DeviceState), &meshtastic_DeviceState_msg, &devicestate);
 
+    bool devicestateLoaded = false;
     if (state != LoadFileResult::LOAD_SUCCESS) {
         installDefaultDeviceState(); // Our in RAM copy might now be corrupt
     } else {
@@ -623,11 +635,36 @@ void NodeDB::loadFromDisk()
         } else {
             LOG_INFO("Loaded saved devicestate version %d, with nodecount: %d\n", devicestate.version,
                      devicestate.node_db_lite.size());
-            meshNodes = &devicestate.node_db_lite;
             numMeshNodes = devicestate.node_db_lite.size();
+            devicestateLoaded = true;
         }
     }
-    meshNodes->resize(MAX_NUM_NODES);
+#ifdef ARCH_PORTDUINO
+    if (mappedNodeStore) {
+        if (devicestateLoaded && mappedNodeStore->getCount() == 0 && numMeshNodes > 0) {
+            LOG_INFO("Moving %d nodes from %s into the node store\n", numMeshNodes, prefFileName);
+            numMeshNodes = std::min((uint32_t)numMeshNodes, mappedNodeStore->capacity());
+            std::copy(devicestate.node_db_lite.begin(), devicestate.node_db_lite.begin() + numMeshNodes, mappedNodeStore->records());
+        } else if (devicestateLoaded) {
+            numMeshNodes = mappedNodeStore->getCount();
+        }
+        devicestate.node_db_lite.clear(); // so db.proto stops carrying them
+        devicestate.node_db_lite.shrink_to_fit();
+    }
+#endif
+    attachNodeRecords();
+    rebuildNodeIndex();
+    fingerprintDeviceState();
+
+    if (devicestateLoaded) {
+        if (replayNodeJournal())
+            saveDeviceStateToDisk(); // fold the journal in now, which also drops anything torn off its end
+    } else {
+#ifdef FSCom
+        if (FSCom.exists(nodeJournalFileName))
+            FSCom.remove(nodeJournalFileName); // changes to a db we no longer have
+#endif
+    }
 
     state = loadProto(configFileName, meshtastic_LocalConfig_size, sizeof(meshtastic_LocalConfig), &meshtastic_LocalConfig_msg,
                       &config);
@@ -711,6 +748,8 @@ bool NodeDB::saveProto(const char *filename, size_t protoSize, const pb_msgdesc_
             LOG_ERROR("Error: can't encode protobuf %s\n", PB_GET_ERROR(&stream));
         } else {
             okay = true;
+            persistStats.protoWrites++;
+            persistStats.protoBytes += stream.bytes_written;
         }
         f.flush();
         f.close();
@@ -757,12 +796,273 @@ void NodeDB::saveDeviceStateToDisk()
 #ifdef FSCom
     FSCom.mkdir("/prefs");
 #endif
-    saveProto(prefFileName, sizeof(devicestate) + numMeshNodes * meshtastic_NodeInfoLite_size, &meshtastic_DeviceState_msg,
-              &devicestate);
+    if (!saveProto(prefFileName, sizeof(devicestate) + numMeshNodes * meshtastic_NodeInfoLite_size, &meshtastic_DeviceState_msg,
+                   &devicestate))
+        return;
+
+#ifdef ARCH_PORTDUINO
+    if (mappedNodeStore)
+        mappedNodeStore->sync(numMeshNodes, true);
+#endif
+    fingerprintDeviceState();
+
+    // Everything the journal had is in db.proto now.  If we lose power before it is gone, its first record no longer matches
+    // db.proto and it won't be replayed.
+    clearNodeChanges();
+#ifdef FSCom
+    if (FSCom.exists(nodeJournalFileName))
+        FSCom.remove(nodeJournalFileName);
+#endif
+    nodeJournalBytes = 0;
+}
+
+void NodeDB::clearNodeChanges()
+{
+    for (auto &hot : hotNodes)
+        hot.changed = false;
+    journalRemovals.clear();
+}
+
+void NodeDB::attachNodeRecords()
+{
+#ifdef ARCH_PORTDUINO
+    if (mappedNodeStore) {
+        meshNodes = {mappedNodeStore->records(), mappedNodeStore->capacity()};
+        return;
+    }
+#endif
+    devicestate.node_db_lite.resize(MAX_NUM_NODES);
+    meshNodes = {devicestate.node_db_lite.data(), devicestate.node_db_lite.size()};
+}
+
+/// Node journal records are: op (1 byte), payload length (2 bytes), CRC32 of the payload (4 bytes), then the payload.  All
+/// little endian.  An upsert carries a whole encoded NodeInfoLite, a removal just the NodeNum.  The first record is always a
+/// base, the size and hash (4 bytes each) of the db.proto the rest applies to.
+#define NODE_JOURNAL_HEADER_LEN 7
+#define NODE_JOURNAL_UPSERT 1
+#define NODE_JOURNAL_REMOVE 2
+#define NODE_JOURNAL_BASE 3
+
+static uint32_t getLE32(const uint8_t *b)
+{
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+void NodeDB::fingerprintDeviceState()
+{
+    nodeJournalBaseSize = 0;
+    nodeJournalBaseHash = 2166136261u; // FNV-1a, we only need to tell one db.proto from the next
+#ifdef FSCom
+    auto f = FSCom.open(prefFileName, FILE_O_READ);
+    if (!f)
+        return;
+
+    uint8_t buf[256];
+    int n;
+    while ((n = f.read(buf, sizeof(buf))) > 0) {
+        for (int i = 0; i < n; i++)
+            nodeJournalBaseHash = (nodeJournalBaseHash ^ buf[i]) * 16777619u;
+        nodeJournalBaseSize += n;
+    }
+    f.close();
+#endif
+}
+
+#ifdef FSCom
+/// @return the bytes written, or 0 on failure
+static size_t appendJournalRecord(File &f, uint8_t op, const uint8_t *payload, uint16_t len)
+{
+    uint32_t crc = crc32Buffer(payload, len);
+    uint8_t header[NODE_JOURNAL_HEADER_LEN] = {
+        op, (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+    if (f.write(header, sizeof(header)) != sizeof(header) || f.write(payload, len) != len)
+        return 0;
+    return sizeof(header) + len;
+}
+#endif
+
+void NodeDB::saveNodeChanges()
+{
+#ifdef ARCH_PORTDUINO
+    if (mappedNodeStore) {
+        // The records were changed in place, the kernel just has to write back the pages they are on
+        mappedNodeStore->sync(numMeshNodes);
+        clearNodeChanges();
+        return;
+    }
+#endif
+#ifdef FSCom
+    if (nodeJournalBytes >= NODE_JOURNAL_MAX_BYTES) {
+        LOG_INFO("Node journal is %u bytes, compacting it into %s\n", nodeJournalBytes, prefFileName);
+        saveDeviceStateToDisk();
+        return;
+    }
+
+    FSCom.mkdir("/prefs");
+    bool fresh = nodeJournalBytes == 0;
+    if (fresh && FSCom.exists(nodeJournalFileName))
+        FSCom.remove(nodeJournalFileName); // left over from a db.proto we have since replaced
+    auto f = FSCom.open(nodeJournalFileName, FILE_O_APPEND);
+    if (!f) {
+        LOG_ERROR("Can't open %s, saving the whole NodeDB instead\n", nodeJournalFileName);
+        saveDeviceStateToDisk();
+        return;
+    }
+
+    bool okay = true;
+    uint32_t records = 0, bytes = 0;
+    uint8_t payload[meshtastic_NodeInfoLite_size];
+
+    if (fresh) {
+        uint32_t s = nodeJournalBaseSize, h = nodeJournalBaseHash;
+        uint8_t base[8] = {(uint8_t)s, (uint8_t)(s >> 8), (uint8_t)(s >> 16), (uint8_t)(s >> 24),
+                           (uint8_t)h, (uint8_t)(h >> 8), (uint8_t)(h >> 16), (uint8_t)(h >> 24)};
+        size_t written = appendJournalRecord(f, NODE_JOURNAL_BASE, base, sizeof(base));
+        okay = written > 0;
+        bytes += written;
+    }
+
+    for (size_t i = 0; okay && i < journalRemovals.size(); i++) {
+        NodeNum n = journalRemovals[i];
+        uint8_t num[4] = {(uint8_t)n, (uint8_t)(n >> 8), (uint8_t)(n >> 16), (uint8_t)(n >> 24)};
+        size_t written = appendJournalRecord(f, NODE_JOURNAL_REMOVE, num, sizeof(num));
+        okay = written > 0;
+        bytes += written;
+        records++;
+    }
+
+    for (int i = 0; okay && i < numMeshNodes; i++) {
+        if (!hotNodes[i].changed)
+            continue;
+
+        pb_ostream_t stream = pb_ostream_from_buffer(payload, sizeof(payload));
+        if (!pb_encode(&stream, &meshtastic_NodeInfoLite_msg, &meshNodes.at(i))) {
+            LOG_ERROR("Error: can't encode node 0x%x for the journal %s\n", hotNodes[i].num, PB_GET_ERROR(&stream));
+            okay = false;
+            break;
+        }
+        size_t written = appendJournalRecord(f, NODE_JOURNAL_UPSERT, payload, stream.bytes_written);
+        okay = written > 0;
+        bytes += written;
+        records++;
+    }
+    f.flush();
+    f.close();
+
+    nodeJournalBytes += bytes;
+    persistStats.journalRecords += records;
+    persistStats.journalBytes += bytes;
+
+    if (!okay) {
+        LOG_ERROR("Can't append to %s, saving the whole NodeDB instead\n", nodeJournalFileName);
+        saveDeviceStateToDisk();
+        return;
+    }
+
+    clearNodeChanges();
+    LOG_DEBUG("Journaled %u node changes (%u bytes)\n", records, bytes);
+#else
+    saveDeviceStateToDisk();
+#endif
+}
+
+bool NodeDB::replayNodeJournal()
+{
+#ifdef FSCom
+    if (!FSCom.exists(nodeJournalFileName))
+        return false;
+
+    auto f = FSCom.open(nodeJournalFileName, FILE_O_READ);
+    if (!f) {
+        LOG_ERROR("Could not open / read %s\n", nodeJournalFileName);
+        return true; // let a fresh db.proto replace it
+    }
+
+    uint8_t header[NODE_JOURNAL_HEADER_LEN];
+    uint8_t payload[meshtastic_NodeInfoLite_size];
+    int applied = 0;
+
+    // A journal that isn't for this db.proto (we lost power compacting it, after db.proto was replaced but before the journal
+    // was deleted) would put back older copies of the nodes, so leave it out entirely
+    bool matches = false;
+    if (f.read(header, sizeof(header)) == (int)sizeof(header) && header[0] == NODE_JOURNAL_BASE && header[1] == 8 &&
+        header[2] == 0 && f.read(payload, 8) == 8)
+        matches = crc32Buffer(payload, 8) == getLE32(header + 3) && getLE32(payload) == nodeJournalBaseSize &&
+                  getLE32(payload + 4) == nodeJournalBaseHash;
+    if (!matches) {
+        LOG_WARN("%s doesn't belong to this %s, not replaying it\n", nodeJournalFileName, prefFileName);
+        f.close();
+        return true; // let a fresh db.proto replace it
+    }
+
+    // Stop at the first record that doesn't check out, it is where we lost power while appending
+    while (f.read(header, sizeof(header)) == (int)sizeof(header)) {
+        uint16_t len = header[1] | (header[2] << 8);
+        uint32_t crc = header[3] | (header[4] << 8) | (header[5] << 16) | ((uint32_t)header[6] << 24);
+        if (len > sizeof(payload) || f.read(payload, len) != (int)len || crc32Buffer(payload, len) != crc) {
+            LOG_WARN("Node journal record %d is torn, ignoring the rest\n", applied);
+            break;
+        }
+
+        if (header[0] == NODE_JOURNAL_REMOVE && len == 4) {
+            purgeNode(payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24));
+        } else if (header[0] == NODE_JOURNAL_UPSERT) {
+            meshtastic_NodeInfoLite node = meshtastic_NodeInfoLite_init_default;
+            pb_istream_t stream = pb_istream_from_buffer(payload, len);
+            meshtastic_NodeInfoLite *info = NULL;
+            if (pb_decode(&stream, &meshtastic_NodeInfoLite_msg, &node))
+                info = getOrCreateMeshNode(node.num);
+            if (info) {
+                *info = node;
+                setLastHeard(info, node.last_heard, node.via_mqtt); // keeps hotNodes in step
+            }
+        }
+        applied++;
+    }
+    f.close();
+
+    LOG_INFO("Replayed %d records from %s\n", applied, nodeJournalFileName);
+    return true;
+#else
+    return false;
+#endif
+}
+
+static int32_t runPendingSaves()
+{
+    nodeDB->flushPendingSaves();
+    return INT32_MAX; // until the next saveToDiskLater()
+}
+
+void NodeDB::saveToDiskLater(int saveWhat)
+{
+    uint32_t now = millis();
+    if (!pendingSaveWhat)
+        pendingSaveSince = now;
+    pendingSaveWhat |= saveWhat;
+
+    // Keep putting it off while changes keep coming in, but not forever
+    uint32_t waited = now - pendingSaveSince;
+    uint32_t delay = CONFIG_SAVE_DELAY_MS;
+    if (waited + delay > CONFIG_SAVE_MAX_DELAY_MS)
+        delay = waited < CONFIG_SAVE_MAX_DELAY_MS ? CONFIG_SAVE_MAX_DELAY_MS - waited : 0;
+
+    if (!pendingSaveThread)
+        pendingSaveThread = new concurrency::Periodic("SaveBehind", runPendingSaves);
+    pendingSaveThread->setIntervalFromNow(delay);
+    LOG_DEBUG("Saving segments 0x%x to disk in %u ms\n", pendingSaveWhat, delay);
+}
+
+void NodeDB::flushPendingSaves()
+{
+    if (pendingSaveWhat)
+        saveToDisk(pendingSaveWhat);
 }
 
 void NodeDB::saveToDisk(int saveWhat)
 {
+    pendingSaveWhat &= ~saveWhat; // whatever we write now is no longer owed by saveToDiskLater()
+
 #ifdef FSCom
     FSCom.mkdir("/prefs");
 #endif
@@ -808,7 +1108,7 @@ void NodeDB::saveToDisk(int saveWhat)
 const meshtastic_NodeInfoLite *NodeDB::readNextMeshNode(uint32_t &readIndex)
 {
     if (readIndex < numMeshNodes)
-        return &meshNodes->at(readIndex++);
+        return &meshNodes.at(readIndex++);
     else
         return NULL;
 }
@@ -836,21 +1136,60 @@ uint32_t sinceReceived(const meshtastic_MeshPacket *p)
     return delta;
 }
 
-#define NUM_ONLINE_SECS (60 * 60 * 2) // 2 hrs to consider someone offline
-
 size_t NodeDB::getNumOnlineMeshNodes(bool localOnly)
 {
-    size_t numseen = 0;
+    advanceOnline(getTime());
+    return numOnline[0] + (localOnly ? 0 : numOnline[1]);
+}
 
-    // FIXME this implementation is kinda expensive
-    for (int i = 0; i < numMeshNodes; i++) {
-        if (localOnly && meshNodes->at(i).via_mqtt)
-            continue;
-        if (sinceLastSeen(&meshNodes->at(i)) < NUM_ONLINE_SECS)
-            numseen++;
+void NodeDB::advanceOnline(uint32_t now)
+{
+    uint32_t bucket = now / ONLINE_BUCKET_SECS;
+    if (bucket == onlineBucketNow)
+        return;
+
+    if (bucket < onlineBucketNow || bucket - onlineBucketNow >= NUM_ONLINE_BUCKETS) {
+        // Our clock was just set (or went backwards), so the buckets we filed things in mean nothing now
+        onlineBucketNow = bucket;
+        recountOnline();
+        return;
+    }
+
+    while (onlineBucketNow != bucket) {
+        uint16_t *counts = onlineCounts[++onlineBucketNow % NUM_ONLINE_BUCKETS]; // the oldest bucket, about to be reused
+        numOnline[0] -= counts[0];
+        numOnline[1] -= counts[1];
+        counts[0] = counts[1] = 0;
     }
 
-    return numseen;
+    if ((int32_t)(onlineBucketNow - firstFutureBucket) >= 0)
+        recountOnline(); // some nodes from the future are now in the window, and need to be filed in a bucket
+}
+
+void NodeDB::countOnline(NodeHot &hot, bool add)
+{
+    uint32_t bucket = hot.lastHeard / ONLINE_BUCKET_SECS;
+    int32_t age = onlineBucketNow - bucket;
+    if (age >= NUM_ONLINE_BUCKETS)
+        return; // aged out already
+
+    int delta = add ? 1 : -1;
+    numOnline[hot.viaMqtt] += delta;
+    if (age >= 0) {
+        onlineCounts[bucket % NUM_ONLINE_BUCKETS][hot.viaMqtt] += delta;
+    } else if (add && (int32_t)(bucket - firstFutureBucket) < 0) {
+        // Heard in the future (our clock isn't set yet), sinceLastSeen() calls that online until the clock gets there
+        firstFutureBucket = bucket;
+    }
+}
+
+void NodeDB::recountOnline()
+{
+    memset(onlineCounts, 0, sizeof(onlineCounts));
+    numOnline[0] = numOnline[1] = 0;
+    firstFutureBucket = onlineBucketNow + INT32_MAX;
+    for (int i = 0; i < numMeshNodes; i++)
+        countOnline(hotNodes[i], true);
 }
 
 #include "MeshModule.h"
@@ -896,6 +1235,7 @@ void NodeDB::updatePosition(uint32_t nodeId, const meshtastic_Position &p, RxSou
             info->position.time = tmp_time;
     }
     info->has_position = true;
+    markNodeChanged(info);
     updateGUIforNode = info;
     notifyObservers(true); // Force an update whether or not our node counts have changed
 }
@@ -919,6 +1259,7 @@ void NodeDB::updateTelemetry(uint32_t nodeId, const meshtastic_Telemetry &t, RxS
     }
     info->device_metrics = t.variant.device_metrics;
     info->has_device_metrics = true;
+    markNodeChanged(info);
     updateGUIforNode = info;
     notifyObservers(true); // Force an update whether or not our node counts have changed
 }
@@ -945,14 +1286,15 @@ bool NodeDB::updateUser(uint32_t nodeId, const meshtastic_User &p, uint8_t chann
     info->has_user = true;
 
     if (changed) {
+        markNodeChanged(info);
         updateGUIforNode = info;
         powerFSM.trigger(EVENT_NODEDB_UPDATED);
         notifyObservers(true); // Force an update whether or not our node counts have changed
 
         // We just changed something about the user, store our DB
         Throttle::execute(
-            &lastNodeDbSave, ONE_MINUTE_MS, []() { nodeDB->saveToDisk(SEGMENT_DEVICESTATE); },
-            []() { LOG_DEBUG("Deferring NodeDB saveToDisk for now, since we saved less than a minute ago\n"); });
+            &lastNodeDbSave, ONE_MINUTE_MS, []() { nodeDB->saveNodeChanges(); },
+            []() { LOG_DEBUG("Deferring NodeDB saveNodeChanges for now, since we saved less than a minute ago\n"); });
     }
 
     return changed;
@@ -970,14 +1312,12 @@ void NodeDB::updateFrom(const meshtastic_MeshPacket &mp)
             return;
         }
 
-        if (mp.rx_time) // if the packet has a valid timestamp use it to update our last_heard
-            info->last_heard = mp.rx_time;
+        // if the packet has a valid timestamp use it to update our last_heard, and store if we received it via MQTT
+        setLastHeard(info, mp.rx_time ? mp.rx_time : info->last_heard, mp.via_mqtt);
 
         if (mp.rx_snr)
             info->snr = mp.rx_snr; // keep the most recent SNR we received for this node.
 
-        info->via_mqtt = mp.via_mqtt; // Store if we received this packet via MQTT
-
         // If hopStart was set and there wasn't someone messing with the limit in the middle, add hopsAway
         if (mp.hop_start != 0 && mp.hop_limit <= mp.hop_start)
             info->hops_away = mp.hop_start - mp.hop_limit;
@@ -993,15 +1333,138 @@ uint8_t NodeDB::getMeshNodeChannel(NodeNum n)
     return info->channel;
 }
 
+#define NODE_INDEX_EMPTY UINT16_MAX
+
+/// NodeNums are mostly the low bytes of a MAC, but mix them anyway so sequential test nodes don't cluster
+static inline size_t nodeHash(NodeNum n)
+{
+    return n * 2654435761UL;
+}
+
+size_t NodeDB::findBucket(NodeNum n) const
+{
+    size_t mask = nodeIndex.size() - 1;
+    size_t i = nodeHash(n) & mask;
+    while (nodeIndex[i] != NODE_INDEX_EMPTY && hotNodes[nodeIndex[i]].num != n)
+        i = (i + 1) & mask;
+    return i;
+}
+
+void NodeDB::rebuildNodeIndex()
+{
+    size_t buckets = 16;
+    while (buckets < 2 * (size_t)MAX_NUM_NODES) // keep the load factor at or below 1/2
+        buckets *= 2;
+    nodeIndex.assign(buckets, NODE_INDEX_EMPTY);
+    evictionHeap.clear();
+    hotNodes.resize(meshNodes.size());
+
+    for (uint16_t i = 0; i < numMeshNodes; i++) {
+        const meshtastic_NodeInfoLite &node = meshNodes.at(i);
+        hotNodes[i] = {node.num, node.last_heard, node.via_mqtt};
+
+        size_t b = findBucket(node.num);
+        if (nodeIndex[b] == NODE_INDEX_EMPTY) // on a duplicate the first one wins, like the old linear scan
+            nodeIndex[b] = i;
+        if (i > 0)
+            pushEviction(i);
+    }
+
+    onlineBucketNow = getTime() / ONLINE_BUCKET_SECS;
+    recountOnline();
+}
+
+void NodeDB::indexErase(NodeNum n)
+{
+    size_t mask = nodeIndex.size() - 1;
+    size_t i = findBucket(n);
+    if (nodeIndex[i] == NODE_INDEX_EMPTY)
+        return;
+
+    // Backward shift deletion, so lookups never need tombstones
+    size_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (nodeIndex[j] == NODE_INDEX_EMPTY)
+            break;
+        size_t home = nodeHash(hotNodes[nodeIndex[j]].num) & mask;
+        // The entry at j can move into the hole at i unless its home lies cyclically in (i, j]
+        bool stays = (i < j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            nodeIndex[i] = nodeIndex[j];
+            i = j;
+        }
+    }
+    nodeIndex[i] = NODE_INDEX_EMPTY;
+}
+
+bool NodeDB::heardLater(const EvictionEntry &a, const EvictionEntry &b)
+{
+    return a.lastHeard > b.lastHeard;
+}
+
+void NodeDB::pushEviction(uint16_t slot)
+{
+    evictionHeap.push_back({hotNodes[slot].lastHeard, slot});
+    std::push_heap(evictionHeap.begin(), evictionHeap.end(), heardLater);
+}
+
+int NodeDB::pickEvictionSlot(bool skipFavorites)
+{
+    std::vector<EvictionEntry> keep; // favorites and ourselves, to go back in the heap afterwards
+    int slot = -1;
+
+    while (!evictionHeap.empty()) {
+        std::pop_heap(evictionHeap.begin(), evictionHeap.end(), heardLater);
+        EvictionEntry e = evictionHeap.back();
+        evictionHeap.pop_back();
+
+        const NodeHot &hot = hotNodes[e.slot];
+        if (hot.lastHeard != e.lastHeard) {
+            // Heard from since we filed it, put it back where it belongs now
+            e.lastHeard = hot.lastHeard;
+            evictionHeap.push_back(e);
+            std::push_heap(evictionHeap.begin(), evictionHeap.end(), heardLater);
+        } else if ((skipFavorites && meshNodes.at(e.slot).is_favorite) || hot.num == getNodeNum()) {
+            keep.push_back(e);
+        } else {
+            slot = e.slot;
+            break;
+        }
+    }
+
+    for (auto &e : keep) {
+        evictionHeap.push_back(e);
+        std::push_heap(evictionHeap.begin(), evictionHeap.end(), heardLater);
+    }
+    return slot;
+}
+
+void NodeDB::setLastHeard(meshtastic_NodeInfoLite *node, uint32_t lastHeard, bool viaMqtt)
+{
+    NodeHot &hot = hotNodes[node - &meshNodes.at(0)];
+    advanceOnline(getTime());
+    countOnline(hot, false);
+    node->last_heard = hot.lastHeard = lastHeard;
+    node->via_mqtt = hot.viaMqtt = viaMqtt;
+    hot.changed = true;
+    countOnline(hot, true);
+}
+
+void NodeDB::markNodeChanged(const meshtastic_NodeInfoLite *node)
+{
+    hotNodes[node - &meshNodes.at(0)].changed = true;
+}
+
 /// Find a node in our DB, return null for missing
 /// NOTE: This function might be called from an ISR
 meshtastic_NodeInfoLite *NodeDB::getMeshNode(NodeNum n)
 {
-    for (int i = 0; i < numMeshNodes; i++)
-        if (meshNodes->at(i).num == n)
-            return &meshNodes->at(i);
+    if (nodeIndex.empty()) // not loaded yet
+        return NULL;
 
-    return NULL;
+    uint16_t slot = nodeIndex[findBucket(n)];
+    return slot != NODE_INDEX_EMPTY ? &meshNodes.at(slot) : NULL;
 }
 
 /// Find a node in our DB, create an empty NodeInfo if missing
@@ -1010,31 +1473,35 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
     meshtastic_NodeInfoLite *lite = getMeshNode(n);
 
     if (!lite) {
+        advanceOnline(getTime()); // first, it might recount everyone
+        int slot = -1;
         if ((numMeshNodes >= MAX_NUM_NODES) || (memGet.getFreeHeap() < meshtastic_NodeInfoLite_size * 3)) {
             if (screen)
                 screen->print("Warn: node database full!\nErasing oldest entry\n");
             LOG_WARN("Node database full! Erasing oldest entry\n");
-            // look for oldest node and erase it
-            uint32_t oldest = UINT32_MAX;
-            int oldestIndex = -1;
-            for (int i = 1; i < numMeshNodes; i++) {
-                if (!meshNodes->at(i).is_favorite && meshNodes->at(i).last_heard < oldest) {
-                    oldest = meshNodes->at(i).last_heard;
-                    oldestIndex = i;
-                }
+            // take over the slot of the oldest node, rather than shoving everyone after it down the chain
+            slot = pickEvictionSlot(true);
+            if (slot < 0)
+                slot = pickEvictionSlot(false); // nothing but favorites left
+            if (slot >= 0) {
+                indexErase(hotNodes[slot].num);
+                countOnline(hotNodes[slot], false);
+                journalRemovals.push_back(hotNodes[slot].num);
             }
-            // Shove the remaining nodes down the chain
-            for (int i = oldestIndex; i < numMeshNodes - 1; i++) {
-                meshNodes->at(i) = meshNodes->at(i + 1);
-            }
-            (numMeshNodes)--;
         }
-        // add the node at the end
-        lite = &meshNodes->at((numMeshNodes)++);
+        if (slot < 0) // add the node at the end
+            slot = (numMeshNodes)++;
+        lite = &meshNodes.at(slot);
 
         // everything is missing except the nodenum
         memset(lite, 0, sizeof(*lite));
         lite->num = n;
+        hotNodes[slot] = {n, 0, false, true};
+        countOnline(hotNodes[slot], true);
+
+        nodeIndex[findBucket(n)] = slot;
+        if (slot > 0)
+            pushEviction(slot);
     }
 
     return lite;
@@ -1059,6 +1526,7 @@ void recordCriticalError(meshtastic_CriticalErrorCode code, uint32_t address, co
     // Currently portuino is mostly used for simulation.  Make sure the user notices something really bad happened
 #ifdef ARCH_PORTDUINO
     LOG_ERROR("A critical failure occurred, portduino is exiting...");
+    portduinoFlushBeforeExit();
     exit(2);
 #endif
 }
\ No newline at end of file
@@ -10,6 +10,11 @@
 #include "mesh-pb-constants.h"
 #include "mesh/generated/meshtastic/mesh.pb.h" // For CriticalErrorCode
 
+namespace concurrency
+{
+class Periodic;
+}
+
 /*
 DeviceState versions used to be defined in the .proto file but really only this function cares.  So changed to a
 #define here.
@@ -23,6 +28,27 @@ DeviceState versions used to be defined in the .proto file but really only this
 #define DEVICESTATE_CUR_VER 23
 #define DEVICESTATE_MIN_VER 22
 
+#define NUM_ONLINE_SECS (60 * 60 * 2) // 2 hrs to consider someone offline
+
+/// Online nodes are counted per bucket of last_heard this many seconds wide, so they can drop offline up to this much early
+#ifndef ONLINE_BUCKET_SECS
+#define ONLINE_BUCKET_SECS (5 * 60)
+#endif
+#define NUM_ONLINE_BUCKETS (NUM_ONLINE_SECS / ONLINE_BUCKET_SECS)
+
+/// saveToDiskLater() waits this long for more changes before writing, but holds on to a change no longer than the max
+#ifndef CONFIG_SAVE_DELAY_MS
+#define CONFIG_SAVE_DELAY_MS 2000
+#endif
+#ifndef CONFIG_SAVE_MAX_DELAY_MS
+#define CONFIG_SAVE_MAX_DELAY_MS 15000
+#endif
+
+/// Once the node journal grows past this, saveNodeChanges() folds it back into a fresh db.proto
+#ifndef NODE_JOURNAL_MAX_BYTES
+#define NODE_JOURNAL_MAX_BYTES (16 * 1024)
+#endif
+
 extern meshtastic_DeviceState devicestate;
 extern meshtastic_ChannelFile channelFile;
 extern meshtastic_MyNodeInfo &myNodeInfo;
@@ -38,6 +64,22 @@ uint32_t sinceLastSeen(const meshtastic_NodeInfoLite *n);
 /// Given a packet, return how many seconds in the past (vs now) it was received
 uint32_t sinceReceived(const meshtastic_MeshPacket *p);
 
+/**
+ * The fixed size array NodeDB keeps its NodeInfoLite records in.  Normally that is devicestate.node_db_lite, but meshtasticd
+ * can keep them in a memory mapped file instead (see MappedNodeStore).
+ */
+struct NodeRecords {
+    meshtastic_NodeInfoLite *base;
+    size_t count;
+
+    meshtastic_NodeInfoLite &at(size_t i)
+    {
+        assert(i < count);
+        return base[i];
+    }
+    size_t size() const { return count; }
+};
+
 enum LoadFileResult {
     // Successfully opened the file
     LOAD_SUCCESS = 1,
@@ -61,7 +103,7 @@ class NodeDB
     // Note: these two references just point into our static array we serialize to/from disk
 
   public:
-    std::vector<meshtastic_NodeInfoLite> *meshNodes;
+    NodeRecords meshNodes = {};
     bool updateGUI = false; // we think the gui should definitely be redrawn, screen will clear this once handled
     meshtastic_NodeInfoLite *updateGUIforNode = NULL; // if currently showing this node, we think you should update the GUI
     Observable<const meshtastic::NodeStatus *> newStatus;
@@ -75,6 +117,34 @@ class NodeDB
     void saveToDisk(int saveWhat = SEGMENT_CONFIG | SEGMENT_MODULECONFIG | SEGMENT_DEVICESTATE | SEGMENT_CHANNELS),
         saveChannelsToDisk(), saveDeviceStateToDisk();
 
+    /**
+     * Like saveToDisk(), but wait CONFIG_SAVE_DELAY_MS (from the latest call) in case more changes follow, so that a burst of
+     * admin messages costs one write per segment.  A saveToDisk() covering a pending segment, or flushPendingSaves(), writes
+     * it right away instead.
+     */
+    void saveToDiskLater(int saveWhat);
+
+    /// Write whatever saveToDiskLater() is still holding on to, needed before we reboot or power off
+    void flushPendingSaves();
+
+    /**
+     * Cheap alternative to saveDeviceStateToDisk() for routine node updates: append just the nodes changed since the last save
+     * to a journal, which loadFromDisk() replays on top of db.proto.  Owner and my_node changes still need a full save.
+     */
+    void saveNodeChanges();
+
+    /// Note that node was changed, so the next saveNodeChanges() includes it
+    void markNodeChanged(const meshtastic_NodeInfoLite *node);
+
+    /// How much we have written to flash since boot, to keep an eye on wear
+    struct PersistStats {
+        uint32_t protoWrites; // whole files rewritten by saveProto()
+        uint32_t protoBytes;
+        uint32_t journalRecords; // node records appended by saveNodeChanges()
+        uint32_t journalBytes;
+    };
+    const PersistStats &getPersistStats() const { return persistStats; }
+
     /** Reinit radio config if needed, because either:
      * a) sometimes a buggy android app might send us bogus settings or
      * b) the client set factory_reset
@@ -139,12 +209,17 @@ class NodeDB
     meshtastic_NodeInfoLite *getMeshNodeByIndex(size_t x)
     {
         assert(x < numMeshNodes);
-        return &meshNodes->at(x);
+        return &meshNodes.at(x);
     }
 
+    /// Callers that only read the node should keep it in a const pointer, last_heard and via_mqtt in particular are ours to
+    /// change (see setLastHeard())
     meshtastic_NodeInfoLite *getMeshNode(NodeNum n);
     size_t getNumMeshNodes() { return numMeshNodes; }
 
+    /// The only way last_heard and via_mqtt should change, so that our scan friendly copy of them stays in sync
+    void setLastHeard(meshtastic_NodeInfoLite *node, uint32_t lastHeard, bool viaMqtt);
+
     void clearLocalPosition();
 
     void setLocalPosition(meshtastic_Position position, bool timeOnly = false)
@@ -162,9 +237,81 @@ class NodeDB
 
   private:
     uint32_t lastNodeDbSave = 0; // when we last saved our db to flash
+
+    PersistStats persistStats = {};
+
+    int pendingSaveWhat = 0;       // segments saveToDiskLater() still owes
+    uint32_t pendingSaveSince = 0; // millis() when the oldest of them was asked for
+    concurrency::Periodic *pendingSaveThread = NULL;
+
+    /// Size of the node journal on flash
+    uint32_t nodeJournalBytes = 0;
+
+    /// Size and hash of the db.proto the node journal applies to, its first record says so
+    uint32_t nodeJournalBaseSize = 0, nodeJournalBaseHash = 0;
+
+    /// Nodes we evicted since the last save, the journal has to say they are gone or replay would bring them back
+    std::vector<NodeNum> journalRemovals;
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
+    /**
+     * The per node fields we probe or scan all the time, kept packed apart from the much bigger NodeInfoLite records so that
+     * index probes, eviction and online counts don't drag whole records through the cache.  hotNodes[i] mirrors meshNodes[i]
+     * (the records stay the copy we persist and hand to the phone), see setLastHeard().
+     */
+    struct NodeHot {
+        NodeNum num;
+        uint32_t lastHeard;
+        bool viaMqtt;
+        bool changed; // since our last save, see markNodeChanged()
+    };
+    std::vector<NodeHot> hotNodes;
+
+    /**
+     * Running count of online nodes, so getNumOnlineMeshNodes() (called on every node update) doesn't have to scan.
+     * Nodes are counted in the bucket of their last_heard, which only changes in setLastHeard() so it also says which bucket
+     * to take them back out of.  A bucket's count is dropped when it falls out of the NUM_ONLINE_BUCKETS wide window ending
+     * at onlineBucketNow.  Indexed by [bucket % NUM_ONLINE_BUCKETS][viaMqtt].
+     * Nodes heard after onlineBucketNow are only in numOnline, until the window reaches firstFutureBucket.
+     */
+    uint16_t onlineCounts[NUM_ONLINE_BUCKETS][2] = {};
+    uint16_t numOnline[2] = {}; // [viaMqtt]
+    uint32_t onlineBucketNow = 0;
+    uint32_t firstFutureBucket = INT32_MAX; // the earliest bucket past onlineBucketNow that someone was heard in
+
+    /// Move the online window up to now, ageing out buckets (or recounting from scratch if the clock jumped)
+    void advanceOnline(uint32_t now);
+
+    /// Add hot to (or remove it from) the online counts
+    void countOnline(NodeHot &hot, bool add);
+
+    void recountOnline();
+
+    /// NodeNum -> index into meshNodes, an open addressed hash table with linear probing.  Empty buckets hold NODE_INDEX_EMPTY.
+    std::vector<uint16_t> nodeIndex;
+
+    /// One entry per node (except our own slot 0), a min-heap on last_heard so we can find who to evict without a scan.
+    /// Everyone writes last_heard directly, so the keys here can be stale; pickEvictionSlot() refreshes them as it goes.
+    struct EvictionEntry {
+        uint32_t lastHeard;
+        uint16_t slot;
+    };
+    std::vector<EvictionEntry> evictionHeap;
+    static bool heardLater(const EvictionEntry &a, const EvictionEntry &b);
+
+    /// Recreate nodeIndex, evictionHeap and the online counts from meshNodes, needed whenever nodes move around in the array
+    void rebuildNodeIndex();
+
+    /// @return the bucket holding n, or the empty bucket where it would go
+    size_t findBucket(NodeNum n) const;
+
+    void indexErase(NodeNum n);
+    void pushEviction(uint16_t slot);
+
+    /// @return the slot of the least recently heard node, or -1 if there is none (not counting favorites if skipFavorites)
+    int pickEvictionSlot(bool skipFavorites);
+
     /// Notify observers of changes to the DB
     void notifyObservers(bool forceUpdate = false)
     {
@@ -176,6 +323,21 @@ class NodeDB
     /// read our db from flash
     void loadFromDisk();
 
+    /// Point meshNodes at wherever our NodeInfoLite records live, sized for MAX_NUM_NODES
+    void attachNodeRecords();
+
+    /// Everything changed so far is safely on flash
+    void clearNodeChanges();
+
+    /// Apply the node journal to what we just loaded from db.proto, @return true if there was a journal
+    bool replayNodeJournal();
+
+    /// Note which db.proto is on flash now, so a journal can tell whether it belongs to it
+    void fingerprintDeviceState();
+
+    /// Take nodeNum out of the DB (without saving), @return how many entries were removed
+    int purgeNode(NodeNum nodeNum);
+
     /// purge db entries without user info
     void cleanupMeshDB();
 
@@ -8,8 +8,66 @@
 
 PacketHistory::PacketHistory()
 {
-    recentPackets.reserve(MAX_NUM_NODES); // Prealloc the worst case # of records - to prevent heap fragmentation
-                                          // setup our periodic task
+    uint32_t wanted = PACKET_HISTORY_SIZE;
+#ifdef ARCH_PORTDUINO
+    if (settingsMap[maxpackethistory] > 0)
+        wanted = settingsMap[maxpackethistory];
+#endif
+    recentPacketsCapacity = PACKET_HISTORY_PROBE;
+    while (recentPacketsCapacity < wanted)
+        recentPacketsCapacity <<= 1;
+
+    // Prealloc the whole table once - to prevent heap fragmentation
+    recentPackets = new PacketRecord[recentPacketsCapacity];
+    memset(recentPackets, 0, recentPacketsCapacity * sizeof(PacketRecord));
+}
+
+PacketHistory::~PacketHistory()
+{
+    delete[] recentPackets;
+}
+
+uint32_t PacketHistory::slotFor(NodeNum sender, PacketId id) const
+{
+    // Packet ids are mostly sequential in their low bits, so mix everything together before masking
+    uint32_t h = sender ^ (id * 0x9E3779B1u);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return h & (recentPacketsCapacity - 1);
+}
+
+PacketRecord *PacketHistory::find(NodeNum sender, PacketId id, uint32_t now)
+{
+    uint32_t slot = slotFor(sender, id);
+    for (int i = 0; i < PACKET_HISTORY_PROBE; i++) {
+        PacketRecord &r = recentPackets[(slot + i) & (recentPacketsCapacity - 1)];
+        if (r.id == id && r.sender == sender) {
+            if ((now - r.rxTimeMsec) >= FLOOD_EXPIRE_TIME) { // Check whether found packet has already expired
+                r.id = 0;                                    // Free it and pretend packet has not been seen recently
+                return NULL;
+            }
+            return &r;
+        }
+    }
+    return NULL;
+}
+
+PacketRecord *PacketHistory::allocRecord(NodeNum sender, PacketId id, uint32_t now)
+{
+    uint32_t slot = slotFor(sender, id);
+    PacketRecord *oldest = NULL;
+    for (int i = 0; i < PACKET_HISTORY_PROBE; i++) {
+        PacketRecord &r = recentPackets[(slot + i) & (recentPacketsCapacity - 1)];
+        if (r.id == 0 || (now - r.rxTimeMsec) >= FLOOD_EXPIRE_TIME)
+            return &r;
+        if (!oldest || (now - r.rxTimeMsec) > (now - oldest->rxTimeMsec))
+            oldest = &r;
+    }
+
+    // Everything nearby is still live, sacrifice the record most likely to be stale anyway
+    evictions++;
+    return oldest;
 }
 
 /**
@@ -23,58 +81,27 @@ bool PacketHistory::wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpd
     }
 
     uint32_t now = millis();
+    NodeNum sender = getFrom(p);
 
-    PacketRecord r;
-    r.id = p->id;
-    r.sender = getFrom(p);
-    r.rxTimeMsec = now;
-
-    auto found = recentPackets.find(r);
-    bool seenRecently = (found != recentPackets.end()); // found not equal to .end() means packet was seen recently
-
-    if (seenRecently && (now - found->rxTimeMsec) >= FLOOD_EXPIRE_TIME) { // Check whether found packet has already expired
-        recentPackets.erase(found);                                       // Erase and pretend packet has not been seen recently
-        found = recentPackets.end();
-        seenRecently = false;
-    }
+    PacketRecord *found = find(sender, p->id, now);
+    bool seenRecently = (found != NULL);
 
     if (seenRecently) {
+        hits++;
         LOG_DEBUG("Found existing packet record for fr=0x%x,to=0x%x,id=0x%x\n", p->from, p->to, p->id);
+    } else {
+        misses++;
     }
 
     if (withUpdate) {
-        if (found != recentPackets.end()) { // delete existing to updated timestamp (re-insert)
-            recentPackets.erase(found);     // as unsorted_set::iterator is const (can't update timestamp - so re-insert..)
+        if (!found) {
+            found = allocRecord(sender, p->id, now);
+            found->sender = sender;
+            found->id = p->id;
         }
-        recentPackets.insert(r);
+        found->rxTimeMsec = now; // refresh the timestamp in place
         printPacket("Add packet record", p);
     }
 
-    // Capacity is reerved, so only purge expired packets if recentPackets fills past 90% capacity
-    // Expiry is normally dealt with after having searched/found a packet (above)
-    if (recentPackets.size() > (MAX_NUM_NODES * 0.9)) {
-        clearExpiredRecentPackets();
-    }
-
     return seenRecently;
 }
-
-/**
- * Iterate through all recent packets, and remove all older than FLOOD_EXPIRE_TIME
- */
-void PacketHistory::clearExpiredRecentPackets()
-{
-    uint32_t now = millis();
-
-    LOG_DEBUG("recentPackets size=%ld\n", recentPackets.size());
-
-    for (auto it = recentPackets.begin(); it != recentPackets.end();) {
-        if ((now - it->rxTimeMsec) >= FLOOD_EXPIRE_TIME) {
-            it = recentPackets.erase(it); // erase returns iterator pointing to element immediately following the one erased
-        } else {
-            ++it;
-        }
-    }
-
-    LOG_DEBUG("recentPackets size=%ld (after clearing expired packets)\n", recentPackets.size());
-}
\ No newline at end of file
@@ -1,40 +1,60 @@
 #pragma once
 
 #include "Router.h"
-#include <unordered_set>
 
 /// We clear our old flood record 10 minutes after we see the last of it
 #define FLOOD_EXPIRE_TIME (10 * 60 * 1000L)
 
+/// Default number of records we keep, rounded up to a power of two.  On native this can be changed from config.yaml
+#ifndef PACKET_HISTORY_SIZE
+#ifdef ARCH_STM32WL
+#define PACKET_HISTORY_SIZE 128
+#else
+#define PACKET_HISTORY_SIZE 512
+#endif
+#endif
+
+/// How many slots (starting at its hash) a record can live in
+#define PACKET_HISTORY_PROBE 8
+
 /**
  * A record of a recent message broadcast
  */
 struct PacketRecord {
     NodeNum sender;
-    PacketId id;
+    PacketId id;         // 0 means this slot is unused
     uint32_t rxTimeMsec; // Unix time in msecs - the time we received it
 
     bool operator==(const PacketRecord &p) const { return sender == p.sender && id == p.id; }
 };
 
-class PacketRecordHashFunction
-{
-  public:
-    size_t operator()(const PacketRecord &p) const { return (std::hash<NodeNum>()(p.sender)) ^ (std::hash<PacketId>()(p.id)); }
-};
-
 /**
  * This is a mixin that adds a record of past packets we have seen
+ *
+ * Records live in a fixed size open addressing table.  A record can only sit in the few slots following its hash, so lookups
+ * are bounded and we never need to sweep the whole table: expired records are simply overwritten when a new record needs their
+ * slot, and if all those slots hold live records we evict the oldest of them.
  */
 class PacketHistory
 {
   private:
-    std::unordered_set<PacketRecord, PacketRecordHashFunction> recentPackets;
+    PacketRecord *recentPackets;
+    uint32_t recentPacketsCapacity; // always a power of two
 
-    void clearExpiredRecentPackets(); // clear all recentPackets older than FLOOD_EXPIRE_TIME
+    uint32_t hits = 0, misses = 0, evictions = 0;
+
+    /// @return the first slot a record for this packet may live in
+    uint32_t slotFor(NodeNum sender, PacketId id) const;
+
+    /// Find the live record for this packet, or NULL if we don't have one
+    PacketRecord *find(NodeNum sender, PacketId id, uint32_t now);
+
+    /// Pick the slot to store a new record for this packet in
+    PacketRecord *allocRecord(NodeNum sender, PacketId id, uint32_t now);
 
   public:
     PacketHistory();
+    ~PacketHistory();
 
     /**
      * Update recentBroadcasts and return true if we have already seen this packet
@@ -42,4 +62,13 @@ class PacketHistory
      * @param withUpdate if true and not found we add an entry to recentPackets
      */
     bool wasSeenRecently(const meshtastic_MeshPacket *p, bool withUpdate = true);
+
+    /// Number of lookups which found a live record
+    uint32_t getHistoryHits() const { return hits; }
+
+    /// Number of lookups which didn't
+    uint32_t getHistoryMisses() const { return misses; }
+
+    /// Number of live records we had to throw away early because the table was too crowded
+    uint32_t getHistoryEvictions() const { return evictions; }
 };
@@ -0,0 +1,60 @@
+#include "PayloadCache.h"
+#include "concurrency/OSThread.h"
+#include <stdlib.h>
+
+/// How many Scopes this thread has open.  Each thread counts its own, so a Scope closing on the MQTT egress thread can't
+/// close (or open) the main loop's
+#ifdef HAS_STD_THREADS
+static thread_local int depth;
+#else
+static int depth;
+#endif
+
+/// What is in the cache right now, cachedFields is NULL if nothing is
+static const pb_msgdesc_t *cachedFields;
+static meshtastic_Data_payload_t cachedPayload;
+static bool cachedOk;
+
+/// Decoded payload, grown to fit the largest message type we have been asked for
+static void *buf;
+static size_t bufSize;
+
+PayloadCache::Scope::Scope()
+{
+    depth++;
+}
+
+PayloadCache::Scope::~Scope()
+{
+    if (--depth == 0 && concurrency::OSThread::isMainThread())
+        cachedFields = NULL; // so nobody outside a dispatch can be handed a stale pointer
+}
+
+bool PayloadCache::fetch(const meshtastic_MeshPacket &mp, const pb_msgdesc_t *fields, size_t size, const void *&result)
+{
+    // The cache itself is shared, so only the main loop gets to use it, other threads (e.g. the MQTT egress thread in
+    // pipeline mode) decode for themselves
+    if (depth == 0 || !concurrency::OSThread::isMainThread())
+        return false;
+
+    auto &payload = mp.decoded.payload;
+    if (cachedFields != fields || cachedPayload.size != payload.size ||
+        memcmp(cachedPayload.bytes, payload.bytes, payload.size) != 0) {
+        if (size > bufSize) {
+            void *bigger = realloc(buf, size);
+            if (!bigger)
+                return false; // let the caller decode it on the stack as before
+            buf = bigger;
+            bufSize = size;
+        }
+
+        memset(buf, 0, size);
+        cachedOk = pb_decode_from_bytes(payload.bytes, payload.size, fields, buf);
+        cachedFields = fields;
+        cachedPayload.size = payload.size;
+        memcpy(cachedPayload.bytes, payload.bytes, payload.size);
+    }
+
+    result = cachedOk ? buf : NULL;
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "mesh-pb-constants.h"
+#include <string.h>
+
+/**
+ * Remembers the last protobuf payload we decoded, so that the modules, the MQTT JSON serializer and whoever else looks at a
+ * received packet while the router is dispatching it only pay for pb_decode once.
+ *
+ * Entries are keyed on the message type and the payload bytes themselves, so a module that rewrites the payload in
+ * alterReceived() just causes a fresh decode for whoever looks next.
+ *
+ * The cache is only live inside a Scope (Router::dispatchReceived opens one around callModules() and the MQTT publish) and
+ * only on the main loop.  Everywhere else get() and decode() just decode into the caller's scratch space, so they
+ * are always safe to call.
+ */
+class PayloadCache
+{
+  public:
+    /// Opens the cache for the duration of one packet dispatch, scopes may nest
+    class Scope
+    {
+      public:
+        Scope();
+        ~Scope();
+    };
+
+    /**
+     * Return mp's payload decoded as fields, or NULL if it does not decode.  The result either points into the cache (valid
+     * until the scope closes or the next get() of some other payload) or at scratch.
+     */
+    template <class T> static const T *get(const meshtastic_MeshPacket &mp, const pb_msgdesc_t *fields, T &scratch)
+    {
+        const void *cached;
+        if (fetch(mp, fields, sizeof(T), cached))
+            return (const T *)cached;
+
+        memset(&scratch, 0, sizeof(scratch));
+        return pb_decode_from_bytes(mp.decoded.payload.bytes, mp.decoded.payload.size, fields, &scratch) ? &scratch : NULL;
+    }
+
+    /// Like get(), but always leaves a private copy in dest, for callers that want to change it
+    template <class T> static bool decode(const meshtastic_MeshPacket &mp, const pb_msgdesc_t *fields, T &dest)
+    {
+        const T *decoded = get(mp, fields, dest);
+        if (decoded && decoded != &dest)
+            memcpy(&dest, decoded, sizeof(dest));
+        return decoded != NULL;
+    }
+
+  private:
+    /**
+     * If the cache is live on this thread, point result at the decoded payload (decoding it first if needed, NULL if it does
+     * not decode) and return true.  Returns false if the caller has to decode it themselves.
+     */
+    static bool fetch(const meshtastic_MeshPacket &mp, const pb_msgdesc_t *fields, size_t size, const void *&result);
+};
@@ -45,6 +45,7 @@ void PhoneAPI::handleStartConfig()
 #ifdef FSCom
         observe(&xModem.packetReady);
 #endif
+        service.attachPhone(toPhoneCursor);
     }
 
     // even if we were already connected - restart our state machine
@@ -524,7 +525,7 @@ bool PhoneAPI::available()
 #endif
 
         if (!packetForPhone)
-            packetForPhone = service.getForPhone();
+            packetForPhone = service.getForPhone(toPhoneCursor);
         hasPacket = !!packetForPhone;
         // LOG_DEBUG("available hasPacket=%d\n", hasPacket);
         return hasPacket;
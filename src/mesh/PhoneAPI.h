@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Observer.h"
+#include "ToPhoneRing.h"
 #include "mesh-pb-constants.h"
 #include <iterator>
 #include <string>
@@ -57,6 +58,9 @@ class PhoneAPI
     /// downloads it
     meshtastic_MeshPacket *packetForPhone = NULL;
 
+    /// How far we have read the packets destined to the phone, kept across reconnects so we resume where we left off
+    ToPhoneRing::Cursor toPhoneCursor;
+
     // file transfer packets destined for phone. Push it to the queue then free it.
     meshtastic_XModem xmodemPacketForPhone = meshtastic_XModem_init_zero;
 
@@ -1,4 +1,5 @@
 #pragma once
+#include "PayloadCache.h"
 #include "SinglePortModule.h"
 
 /**
@@ -57,7 +58,7 @@ template <class T> class ProtobufModule : protected SinglePortModule
      */
     const char *getSenderShortName(const meshtastic_MeshPacket &mp)
     {
-        auto node = nodeDB->getMeshNode(getFrom(&mp));
+        const auto *node = nodeDB->getMeshNode(getFrom(&mp));
         const char *sender = (node) ? node->user.short_name : "???";
         return sender;
     }
@@ -87,8 +88,8 @@ template <class T> class ProtobufModule : protected SinglePortModule
         T scratch;
         T *decoded = NULL;
         if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag && mp.decoded.portnum == ourPortNum) {
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, &scratch)) {
+            // Handlers get their own copy, but the decode is shared with every other module on this port
+            if (PayloadCache::decode(mp, fields, scratch)) {
                 decoded = &scratch;
             } else {
                 LOG_ERROR("Error decoding protobuf module!\n");
@@ -107,9 +108,7 @@ template <class T> class ProtobufModule : protected SinglePortModule
         T scratch;
         T *decoded = NULL;
         if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag && mp.decoded.portnum == ourPortNum) {
-            memset(&scratch, 0, sizeof(scratch));
-            auto &p = mp.decoded;
-            if (pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, &scratch)) {
+            if (PayloadCache::decode(mp, fields, scratch)) {
                 decoded = &scratch;
             } else {
                 LOG_ERROR("Error decoding protobuf module!\n");
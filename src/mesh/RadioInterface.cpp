@@ -184,7 +184,7 @@ separated by 2.16 MHz with respect to the adjacent channels. Channel zero starts
  *
  * @return num msecs for the packet
  */
-uint32_t RadioInterface::getPacketTime(uint32_t pl)
+uint32_t RadioInterface::computePacketTimeUsec(uint32_t pl)
 {
     float bandwidthHz = bw * 1000.0f;
     bool headDisable = false; // we currently always use the header
@@ -198,11 +198,27 @@ uint32_t RadioInterface::getPacketTime(uint32_t pl)
     float tPayload = numPayloadSym * tSym;
     float tPacket = tPreamble + tPayload;
 
-    uint32_t msecs = tPacket * 1000;
+    return tPacket * 1000000;
+}
+
+void RadioInterface::buildPacketTimeTable()
+{
+    for (uint32_t pl = 0; pl <= MAX_RHPACKETLEN; pl++)
+        packetTimeUsec[pl] = computePacketTimeUsec(pl);
+    packetTimePreambleLength = preambleLength;
+
+    LOG_DEBUG("(bw=%d, sf=%d, cr=4/%d, preamble=%u) packet time %u..%u us\n", (int)bw, sf, cr, preambleLength, packetTimeUsec[0],
+              packetTimeUsec[MAX_RHPACKETLEN]);
+}
+
+uint32_t RadioInterface::getPacketTime(uint32_t pl)
+{
+    // Some radios pick their preamble length after applyModemConfig(), so check that too
+    if (packetTimePreambleLength != preambleLength)
+        buildPacketTimeTable();
 
-    LOG_DEBUG("(bw=%d, sf=%d, cr=4/%d) packet symLen=%d ms, payloadSize=%u, time %d ms\n", (int)bw, sf, cr, (int)(tSym * 1000),
-              pl, msecs);
-    return msecs;
+    uint32_t usecs = (pl <= MAX_RHPACKETLEN) ? packetTimeUsec[pl] : computePacketTimeUsec(pl);
+    return usecs / 1000;
 }
 
 uint32_t RadioInterface::getPacketTime(const meshtastic_MeshPacket *p)
@@ -220,8 +236,11 @@ uint32_t RadioInterface::getPacketTime(const meshtastic_MeshPacket *p)
 /** The delay to use for retransmitting dropped packets */
 uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
 {
-    size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
-    uint32_t packetAirtime = getPacketTime(numbytes + sizeof(PacketHeader));
+    return getRetransmissionMsec(getPacketTime(p));
+}
+
+uint32_t RadioInterface::getRetransmissionMsec(uint32_t packetAirtime)
+{
     // Make sure enough time has elapsed for this packet to be sent and an ACK is received.
     // LOG_DEBUG("Waiting for flooding message with airtime %d and slotTime is %d\n", packetAirtime, slotTimeMsec);
     float channelUtil = airTime->channelUtilizationPercent();
@@ -512,6 +531,7 @@ void RadioInterface::applyModemConfig()
     saveChannelNum(channel_num);
     saveFreq(freq + loraConfig.frequency_offset);
 
+    buildPacketTimeTable();
     preambleTimeMsec = getPacketTime((uint32_t)0);
     maxPacketTimeMsec = getPacketTime(meshtastic_Constants_DATA_PAYLOAD_LEN + sizeof(PacketHeader));
 
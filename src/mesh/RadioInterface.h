@@ -80,6 +80,11 @@ class RadioInterface
     const uint8_t CWmin = 2; // minimum CWsize
     const uint8_t CWmax = 8; // maximum CWsize
 
+    /// Airtime in usecs for every possible on air length (header included), rebuilt when the modem settings change
+    uint32_t packetTimeUsec[MAX_RHPACKETLEN + 1];
+    /// The preamble length packetTimeUsec was built for, 0 if it needs to be (re)built
+    uint16_t packetTimePreambleLength = 0;
+
     meshtastic_MeshPacket *sendingPacket = NULL; // The packet we are currently sending
     uint32_t lastTxStart = 0L;
 
@@ -151,6 +156,8 @@ class RadioInterface
 
     /** The delay to use for retransmitting dropped packets */
     uint32_t getRetransmissionMsec(const meshtastic_MeshPacket *p);
+    /// Same, if the caller already knows the airtime of the packet
+    uint32_t getRetransmissionMsec(uint32_t packetAirtimeMsec);
 
     /** The delay to use when we want to send something */
     uint32_t getTxDelayMsec();
@@ -215,6 +222,12 @@ class RadioInterface
     virtual void saveChannelNum(uint32_t savedChannelNum);
 
   private:
+    /// Work out the airtime of a packet with the current modem settings the slow way, in usecs
+    uint32_t computePacketTimeUsec(uint32_t totalPacketLen);
+
+    /// Fill packetTimeUsec for the current modem settings
+    void buildPacketTimeTable();
+
     /**
      * Convert our modemConfig enum into wf, sf, etc...
      *
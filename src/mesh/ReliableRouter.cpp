@@ -21,16 +21,23 @@ ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
             p->hop_limit = Default::getConfiguredOrDefaultHopLimit(config.lora.hop_limit);
         }
 
-        auto copy = packetPool.allocCopy(*p);
-        startRetransmission(copy);
+        // Router::send makes its own copy before it encrypts, so the pending record can just share this one
+        startRetransmission(packetPool.share(p));
     }
 
     /* If we have pending retransmissions, add the airtime of this packet to it, because during that time we cannot receive an
        (implicit) ACK. Otherwise, we might retransmit too early.
+       We do that for all of them at once by growing our airtime debt, only the record for this packet itself is exempt.
      */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        if (i->first.id != p->id) {
-            i->second.nextTxMsec += iface->getPacketTime(p);
+    if (!pending.empty()) {
+        auto self = findPendingPacket(getFrom(p), p->id);
+        uint32_t airtime = self ? self->packetTimeMsec : iface->getPacketTime(p);
+        airtimeDebtMsec += airtime;
+
+        if (self) {
+            wheelRemove(self);
+            self->nextTxMsec -= airtime;
+            wheelInsert(self);
         }
     }
 
@@ -68,8 +75,8 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
        because while receiving this packet, we could not have received an (implicit) ACK for it.
        If we don't add this, we will likely retransmit too early.
     */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        i->second.nextTxMsec += iface->getPacketTime(p);
+    if (!pending.empty()) {
+        airtimeDebtMsec += iface->getPacketTime(p);
     }
 
     /* Resend implicit ACKs for repeated packets (hopStart equals hopLimit);
@@ -173,9 +180,10 @@ bool ReliableRouter::stopRetransmission(GlobalPacketId key)
         if (old->numRetransmissions < NUM_RETRANSMISSIONS - 1) {
             // remove the 'original' (identified by originator and packet->id) from the txqueue and free it
             cancelSending(getFrom(p), p->id);
-            // now free the pooled copy for retransmission too
-            packetPool.release(p);
         }
+        // now drop our reference to the pooled copy for retransmission too
+        packetPool.release(p);
+        wheelRemove(old);
         auto numErased = pending.erase(key);
         assert(numErased == 1);
         return true;
@@ -190,13 +198,16 @@ PendingPacket *ReliableRouter::startRetransmission(meshtastic_MeshPacket *p)
 {
     auto id = GlobalPacketId(p);
     auto rec = PendingPacket(p);
+    rec.packetTimeMsec = iface->getPacketTime(p);
 
     stopRetransmission(getFrom(p), p->id);
 
-    setNextTx(&rec);
-    pending[id] = rec;
+    // Records must be in the map before they go in the wheel, the wheel links point at them
+    auto &stored = pending[id];
+    stored = rec;
+    setNextTx(&stored);
 
-    return &pending[id];
+    return &stored;
 }
 
 /**
@@ -204,57 +215,142 @@ PendingPacket *ReliableRouter::startRetransmission(meshtastic_MeshPacket *p)
  */
 int32_t ReliableRouter::doRetransmissions()
 {
-    uint32_t now = millis();
-    int32_t d = INT32_MAX;
-
-    // FIXME, we should use a better datastructure rather than walking through this map.
-    // for(auto el: pending) {
-    for (auto it = pending.begin(), nextIt = it; it != pending.end(); it = nextIt) {
-        ++nextIt; // we use this odd pattern because we might be deleting it...
-        auto &p = it->second;
+    uint32_t now = airtimeNow();
+    uint32_t nowTick = now >> RETRANSMIT_TICK_SHIFT;
+    const uint32_t mask = RETRANSMIT_WHEEL_SLOTS - 1;
 
-        bool stillValid = true; // assume we'll keep this record around
+    if (pending.empty()) {
+        wheelTick = nowTick; // nothing to catch up on
+        return INT32_MAX;
+    }
 
-        // FIXME, handle 51 day rolloever here!!!
-        if (p.nextTxMsec <= now) {
-            if (p.numRetransmissions == 0) {
-                LOG_DEBUG("Reliable send failed, returning a nak for fr=0x%x,to=0x%x,id=0x%x\n", p.packet->from, p.packet->to,
-                          p.packet->id);
-                sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p.packet), p.packet->id, p.packet->channel);
+    // Walk the level 0 slots we haven't processed yet, up to and including the current tick
+    while (true) {
+        // Detach the slot first: firing a record reschedules it (or deletes it), possibly into this very slot
+        PendingPacket *due = wheel[0][wheelTick & mask];
+        wheel[0][wheelTick & mask] = NULL;
+        if (due)
+            due->wheelPrev = &due;
+
+        PendingPacket *p;
+        while ((p = due) != NULL) {
+            wheelRemove(p);
+
+            if ((int32_t)(now - p->nextTxMsec) < 0) {
+                wheelInsert(p); // Not quite yet, it lands back in the current slot
+            } else if (p->numRetransmissions == 0) {
+                LOG_DEBUG("Reliable send failed, returning a nak for fr=0x%x,to=0x%x,id=0x%x\n", p->packet->from, p->packet->to,
+                          p->packet->id);
+                sendAckNak(meshtastic_Routing_Error_MAX_RETRANSMIT, getFrom(p->packet), p->packet->id, p->packet->channel);
                 // Note: we don't stop retransmission here, instead the Nak packet gets processed in sniffReceived
-                stopRetransmission(it->first);
-                stillValid = false; // just deleted it
+                stopRetransmission(GlobalPacketId(p->packet)); // deletes p
             } else {
-                LOG_DEBUG("Sending reliable retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d\n", p.packet->from,
-                          p.packet->to, p.packet->id, p.numRetransmissions);
+                LOG_DEBUG("Sending reliable retransmission fr=0x%x,to=0x%x,id=0x%x, tries left=%d\n", p->packet->from,
+                          p->packet->to, p->packet->id, p->numRetransmissions);
 
                 // Note: we call the superclass version because we don't want to have our version of send() add a new
                 // retransmission record
-                FloodingRouter::send(packetPool.allocCopy(*p.packet));
+                FloodingRouter::send(packetPool.share(p->packet));
 
                 // Queue again
-                --p.numRetransmissions;
-                setNextTx(&p);
+                --p->numRetransmissions;
+                setNextTx(p);
             }
         }
 
-        if (stillValid) {
-            // Update our desired sleep delay
-            int32_t t = p.nextTxMsec - now;
+        // Note: airtimeNow() goes backwards when we add airtime debt, so we might even be behind wheelTick
+        if ((int32_t)(nowTick - wheelTick) <= 0)
+            break;
+        wheelTick++;
+
+        // Every time level 0 wraps, spread the next level 1 slot out over it
+        if ((wheelTick & mask) == 0) {
+            PendingPacket *later = wheel[1][(wheelTick >> RETRANSMIT_WHEEL_BITS) & mask];
+            wheel[1][(wheelTick >> RETRANSMIT_WHEEL_BITS) & mask] = NULL;
+            if (later)
+                later->wheelPrev = &later;
+            while ((p = later) != NULL) {
+                wheelRemove(p);
+                wheelInsert(p);
+            }
+        }
+    }
 
-            d = min(t, d);
+    // Our desired sleep delay is until the earliest record in the first non empty slot of either level
+    int32_t d = INT32_MAX;
+    for (uint32_t i = 0; i < RETRANSMIT_WHEEL_SLOTS; i++) {
+        PendingPacket *list = wheel[0][(wheelTick + i) & mask];
+        if (list) {
+            d = earliestIn(list, now, d);
+            break;
+        }
+    }
+    for (uint32_t i = 1; i <= RETRANSMIT_WHEEL_SLOTS; i++) {
+        PendingPacket *list = wheel[1][((wheelTick >> RETRANSMIT_WHEEL_BITS) + i) & mask];
+        if (list) {
+            d = earliestIn(list, now, d);
+            break;
         }
     }
 
     return d;
 }
 
+int32_t ReliableRouter::earliestIn(PendingPacket *list, uint32_t now, int32_t d)
+{
+    for (PendingPacket *p = list; p; p = p->wheelNext) {
+        int32_t t = p->nextTxMsec - now;
+        d = min(max(t, (int32_t)0), d);
+    }
+    return d;
+}
+
+void ReliableRouter::wheelInsert(PendingPacket *p)
+{
+    assert(!p->wheelPrev);
+    const uint32_t mask = RETRANSMIT_WHEEL_SLOTS - 1;
+
+    // Anything already due goes in the current slot, anything too far out in the last slot we have (and gets re-sorted when
+    // that slot cascades)
+    uint32_t tick = p->nextTxMsec >> RETRANSMIT_TICK_SHIFT;
+    int32_t delta = tick - wheelTick;
+    if (delta < 0)
+        delta = 0;
+    else if (delta >= RETRANSMIT_WHEEL_SLOTS * RETRANSMIT_WHEEL_SLOTS)
+        delta = RETRANSMIT_WHEEL_SLOTS * RETRANSMIT_WHEEL_SLOTS - 1;
+    tick = wheelTick + delta;
+
+    PendingPacket **slot = (delta < RETRANSMIT_WHEEL_SLOTS) ? &wheel[0][tick & mask]
+                                                            : &wheel[1][(tick >> RETRANSMIT_WHEEL_BITS) & mask];
+    p->wheelNext = *slot;
+    p->wheelPrev = slot;
+    if (*slot)
+        (*slot)->wheelPrev = &p->wheelNext;
+    *slot = p;
+}
+
+void ReliableRouter::wheelRemove(PendingPacket *p)
+{
+    if (!p->wheelPrev)
+        return;
+
+    *p->wheelPrev = p->wheelNext;
+    if (p->wheelNext)
+        p->wheelNext->wheelPrev = p->wheelPrev;
+    p->wheelNext = NULL;
+    p->wheelPrev = NULL;
+}
+
 void ReliableRouter::setNextTx(PendingPacket *pending)
 {
     assert(iface);
-    auto d = iface->getRetransmissionMsec(pending->packet);
-    pending->nextTxMsec = millis() + d;
+    auto d = iface->getRetransmissionMsec(pending->packetTimeMsec);
+    if (this->pending.size() == 1 && !pending->wheelPrev)
+        wheelTick = airtimeNow() >> RETRANSMIT_TICK_SHIFT; // the wheel was idle, don't make doRetransmissions catch up on it
+    pending->nextTxMsec = airtimeNow() + d;
+    wheelRemove(pending);
+    wheelInsert(pending);
     LOG_DEBUG("Setting next retransmission in %u msecs: ", d);
     printPacket("", pending->packet);
     setReceivedMessage(); // Run ASAP, so we can figure out our correct sleep time
-}
\ No newline at end of file
+}
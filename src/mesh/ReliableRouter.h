@@ -32,16 +32,29 @@ struct GlobalPacketId {
 struct PendingPacket {
     meshtastic_MeshPacket *packet;
 
-    /** The next time we should try to retransmit this packet */
+    /** The next time we should try to retransmit this packet, in airtime adjusted msecs (see ReliableRouter::airtimeNow) */
     uint32_t nextTxMsec = 0;
 
     /** Starts at NUM_RETRANSMISSIONS -1(normally 3) and counts down.  Once zero it will be removed from the list */
     uint8_t numRetransmissions = 0;
 
+    /** Airtime of packet, worked out once so we don't have to protobuf encode it again for every retransmission */
+    uint32_t packetTimeMsec = 0;
+
+    /** Links for the timer wheel slot we are in, wheelPrev points at whatever points at us (NULL if not in the wheel) */
+    PendingPacket *wheelNext = NULL;
+    PendingPacket **wheelPrev = NULL;
+
     PendingPacket() {}
     explicit PendingPacket(meshtastic_MeshPacket *p);
 };
 
+/// Each tick of the retransmission timer wheel is 2^7 = 128 msecs
+#define RETRANSMIT_TICK_SHIFT 7
+/// Each wheel level has 2^6 = 64 slots, so with two levels we cover about 8 minutes
+#define RETRANSMIT_WHEEL_BITS 6
+#define RETRANSMIT_WHEEL_SLOTS (1 << RETRANSMIT_WHEEL_BITS)
+
 class GlobalPacketIdHashFunction
 {
   public:
@@ -56,6 +69,19 @@ class ReliableRouter : public FloodingRouter
   private:
     std::unordered_map<GlobalPacketId, PendingPacket, GlobalPacketIdHashFunction> pending;
 
+    /**
+     * Total airtime of everything we sent or heard while retransmissions were pending.  During that airtime we could not have
+     * received an (implicit) ACK, so all retransmission timers are stretched by it.  Rather than bumping every pending record,
+     * records are scheduled against airtimeNow() = millis() - airtimeDebtMsec, which simply runs slower while the channel is busy.
+     */
+    uint32_t airtimeDebtMsec = 0;
+
+    /// Two level hierarchical timer wheel of pending records, level 1 slots are cascaded into level 0 as time passes
+    PendingPacket *wheel[2][RETRANSMIT_WHEEL_SLOTS] = {};
+
+    /// The level 0 tick the wheel has been processed up to
+    uint32_t wheelTick = 0;
+
   public:
     /**
      * Constructor
@@ -120,4 +146,15 @@ class ReliableRouter : public FloodingRouter
     int32_t doRetransmissions();
 
     void setNextTx(PendingPacket *pending);
+
+    uint32_t airtimeNow() { return millis() - airtimeDebtMsec; }
+
+    /// Add this record to the timer wheel slot for its nextTxMsec
+    void wheelInsert(PendingPacket *p);
+
+    /// Take this record out of whatever wheel slot it is in (if any)
+    void wheelRemove(PendingPacket *p);
+
+    /// @return the earliest nextTxMsec of the records in this slot list, relative to now
+    static int32_t earliestIn(PendingPacket *list, uint32_t now, int32_t d);
 };
@@ -2,7 +2,9 @@
 #include "Channels.h"
 #include "CryptoEngine.h"
 #include "MeshRadio.h"
+#include "MeshService.h"
 #include "NodeDB.h"
+#include "PayloadCache.h"
 #include "RTC.h"
 #include "configuration.h"
 #include "main.h"
@@ -13,6 +15,7 @@
 #endif
 #include "Default.h"
 #if ARCH_PORTDUINO
+#include "platform/portduino/PacketPipeline.h"
 #include "platform/portduino/PortduinoGlue.h"
 #endif
 #if ENABLE_JSON_LOGGING || ARCH_PORTDUINO
@@ -33,17 +36,30 @@
 
 // I think this is right, one packet for each of the three fifos + one packet being currently assembled for TX or RX
 // And every TX packet might have a retransmission packet or an ack alive at any moment
+// Can be overridden from the build flags, anything beyond this many packets in flight will spill over to the heap
+#ifndef MAX_PACKETS
+#ifdef ARCH_STM32WL
+#define MAX_PACKETS 8 // RAM is too tight to reserve a full slab, rely on the heap overflow instead
+#else
 #define MAX_PACKETS                                                                                                              \
     (MAX_RX_TOPHONE + MAX_RX_FROMRADIO + 2 * MAX_TX_QUEUE +                                                                      \
      2) // max number of packets which can be in flight (either queued from reception or queued for sending)
+#endif
+#endif
 
-// static MemoryPool<MeshPacket> staticPool(MAX_PACKETS);
-static MemoryDynamic<meshtastic_MeshPacket> staticPool;
+static MemoryPool<meshtastic_MeshPacket, MAX_PACKETS> staticPool;
 
 Allocator<meshtastic_MeshPacket> &packetPool = staticPool;
 
+MemoryPoolStats getPacketPoolStats()
+{
+    return staticPool.getStats();
+}
+
 static uint8_t bytes[MAX_RHPACKETLEN];
 
+static void logDecoded(const meshtastic_MeshPacket *p);
+
 /**
  * Constructor
  *
@@ -76,6 +92,17 @@ int32_t Router::runOnce()
         perhapsHandleReceived(mp);
     }
 
+#if ARCH_PORTDUINO
+    PacketPipeline::RxItem rx;
+    while (packetPipeline && packetPipeline->takeDecoded(rx)) {
+        if (rx.decoded)
+            logDecoded(rx.p); // skipped by decryptAndDecode() on the decode thread
+        dispatchReceived(rx.p, rx.encrypted, rx.decoded, RX_SRC_RADIO);
+        packetPool.release(rx.encrypted);
+        packetPool.release(rx.p);
+    }
+#endif
+
     // LOG_DEBUG("sleeping forever!\n");
     return INT32_MAX; // Wait a long time - until we get woken for the message queue
 }
@@ -211,6 +238,9 @@ void printBytes(const char *label, const uint8_t *p, size_t numbytes)
  */
 ErrorCode Router::send(meshtastic_MeshPacket *p)
 {
+    // We are about to change hop/from fields and encrypt in place, so make sure we don't scribble on a shared copy
+    p = packetPool.makeWritable(p);
+
     if (p->to == nodeDB->getNodeNum()) {
         LOG_ERROR("BUG! send() called with packet destined for local node!\n");
         packetPool.release(p);
@@ -272,7 +302,15 @@ ErrorCode Router::send(meshtastic_MeshPacket *p)
 #if !MESHTASTIC_EXCLUDE_MQTT
         // Only publish to MQTT if we're the original transmitter of the packet
         if (moduleConfig.mqtt.enabled && p->from == nodeDB->getNodeNum() && mqtt) {
-            mqtt->onSend(*p, *p_decoded, chIndex);
+#if ARCH_PORTDUINO
+            if (packetPipeline) {
+                // p is about to go to the radio, so give the egress thread a copy it can read at leisure
+                meshtastic_MeshPacket *p_copy = packetPool.allocCopy(*p);
+                packetPipeline->submitForEgress(p_copy, p_decoded, chIndex);
+                packetPool.release(p_copy);
+            } else
+#endif
+                mqtt->onSend(*p, *p_decoded, chIndex);
         }
 #endif
         packetPool.release(p_decoded);
@@ -297,10 +335,22 @@ void Router::sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Rout
     // FIXME, update nodedb here for any packet that passes through us
 }
 
-bool perhapsDecode(meshtastic_MeshPacket *p)
+const meshtastic_MeshPacket *Router::getReceivedEncrypted(const meshtastic_MeshPacket *p)
 {
-    concurrency::LockGuard g(cryptLock);
+    if (!rxEncrypted || rxEncrypted->which_payload_variant != meshtastic_MeshPacket_encrypted_tag ||
+        p->which_payload_variant != meshtastic_MeshPacket_decoded_tag || rxEncrypted->from != p->from ||
+        rxEncrypted->id != p->id)
+        return NULL;
 
+    // Modules like traceroute rewrite the payload before it is flooded onwards, in that case we must encrypt again
+    if (p->decoded.payload.size != rxPayload.size || memcmp(p->decoded.payload.bytes, rxPayload.bytes, rxPayload.size) != 0)
+        return NULL;
+
+    return rxEncrypted;
+}
+
+bool isDecodeAllowed(const meshtastic_MeshPacket *p)
+{
     if (config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER &&
         config.device.rebroadcast_mode == meshtastic_Config_DeviceConfig_RebroadcastMode_ALL_SKIP_DECODING)
         return false;
@@ -311,15 +361,41 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
         return false;
     }
 
+    return true;
+}
+
+bool perhapsDecode(meshtastic_MeshPacket *p)
+{
+    return isDecodeAllowed(p) && decryptAndDecode(p);
+}
+
+/// Log a freshly decoded packet, plus its JSON when tracing
+static void logDecoded(const meshtastic_MeshPacket *p)
+{
+    printPacket("decoded message", p);
+#if ENABLE_JSON_LOGGING
+    LOG_TRACE("%s\n", MeshPacketSerializer::JsonSerialize(p, false).c_str());
+#elif ARCH_PORTDUINO
+    if (settingsStrings[traceFilename] != "" || settingsMap[logoutputlevel] == level_trace) {
+        LOG_TRACE("%s\n", MeshPacketSerializer::JsonSerialize(p, false).c_str());
+    }
+#endif
+}
+
+bool decryptAndDecode(meshtastic_MeshPacket *p)
+{
+    concurrency::LockGuard g(cryptLock);
+
     if (p->which_payload_variant == meshtastic_MeshPacket_decoded_tag)
         return true; // If packet was already decoded just return
 
     // assert(p->which_payloadVariant == MeshPacket_encrypted_tag);
 
-    // Try to find a channel that works with this hash
-    for (ChannelIndex chIndex = 0; chIndex < channels.getNumChannels(); chIndex++) {
+    // Only try the channels that have this hash
+    uint8_t candidates = channels.getChannelsForHash(p->channel);
+    for (ChannelIndex chIndex = 0; candidates; chIndex++, candidates >>= 1) {
         // Try to use this hash/channel pair
-        if (channels.decryptForHash(chIndex, p->channel)) {
+        if ((candidates & 1) && channels.decryptForHash(chIndex, p->channel)) {
             // Try to decrypt the packet if we can
             size_t rawSize = p->encrypted.size;
             if (rawSize > sizeof(bytes)) {
@@ -363,14 +439,9 @@ bool perhapsDecode(meshtastic_MeshPacket *p)
                     p->decoded.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
                 } */
 
-                printPacket("decoded message", p);
-#if ENABLE_JSON_LOGGING
-                LOG_TRACE("%s\n", MeshPacketSerializer::JsonSerialize(p, false).c_str());
-#elif ARCH_PORTDUINO
-                if (settingsStrings[traceFilename] != "" || settingsMap[logoutputlevel] == level_trace) {
-                    LOG_TRACE("%s\n", MeshPacketSerializer::JsonSerialize(p, false).c_str());
-                }
-#endif
+                // The JSON trace can look at the NodeDB, so off the main loop it waits for Router::runOnce()
+                if (concurrency::OSThread::isMainThread())
+                    logDecoded(p);
                 return true;
             }
         }
@@ -461,7 +532,6 @@ NodeNum Router::getNodeNum()
  */
 void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
 {
-    bool skipHandle = false;
     // Also, we should set the time from the ISR and it should have msec level resolution
     p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
     // Store a copy of encrypted packet for MQTT
@@ -469,6 +539,14 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
 
     // Take those raw bytes and convert them back into a well structured protobuf we can understand
     bool decoded = perhapsDecode(p);
+    dispatchReceived(p, p_encrypted, decoded, src);
+
+    packetPool.release(p_encrypted); // Release the encrypted packet
+}
+
+void Router::dispatchReceived(meshtastic_MeshPacket *p, const meshtastic_MeshPacket *p_encrypted, bool decoded, RxSource src)
+{
+    bool skipHandle = false;
     if (decoded) {
         // parsing was successful, queue for our recipient
         if (src == RX_SRC_LOCAL)
@@ -506,20 +584,40 @@ void Router::handleReceived(meshtastic_MeshPacket *p, RxSource src)
 
     // call modules here
     if (!skipHandle) {
+        PayloadCache::Scope payloadScope; // the modules and the MQTT JSON serializer share one decode of the payload
+
+        if (decoded) {
+            rxEncrypted = p_encrypted;
+            rxPayload.size = p->decoded.payload.size;
+            memcpy(rxPayload.bytes, p->decoded.payload.bytes, rxPayload.size);
+        }
         MeshModule::callModules(*p, src);
+        // Note: if a module sent a broadcast this got cleared by the nested call, we then just encrypt again as we used to
+        rxEncrypted = NULL;
+
+        // Every module has seen this ACK/NAK now, so the request it answers is no longer outstanding
+        if (decoded && p->decoded.portnum == meshtastic_PortNum_ROUTING_APP && p->decoded.request_id)
+            service.forgetRequest(p->decoded.request_id);
 
 #if !MESHTASTIC_EXCLUDE_MQTT
         // After potentially altering it, publish received message to MQTT if we're not the original transmitter of the packet
-        if (decoded && moduleConfig.mqtt.enabled && getFrom(p) != nodeDB->getNodeNum() && mqtt)
-            mqtt->onSend(*p_encrypted, *p, p->channel);
+        if (decoded && moduleConfig.mqtt.enabled && getFrom(p) != nodeDB->getNodeNum() && mqtt) {
+#if ARCH_PORTDUINO
+            if (packetPipeline)
+                packetPipeline->submitForEgress(p_encrypted, p, p->channel);
+            else
+#endif
+                mqtt->onSend(*p_encrypted, *p, p->channel);
+        }
 #endif
     }
-
-    packetPool.release(p_encrypted); // Release the encrypted packet
 }
 
 void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
 {
+    // We decode in place below, so we need our own copy if someone else is still holding this packet
+    p = packetPool.makeWritable(p);
+
 #if ENABLE_JSON_LOGGING
     // Even ignored packets get logged in the trace
     p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
@@ -542,8 +640,17 @@ void Router::perhapsHandleReceived(meshtastic_MeshPacket *p)
 
     // Note: we avoid calling shouldFilterReceived if we are supposed to ignore certain nodes - because some overrides might
     // cache/learn of the existence of nodes (i.e. FloodRouter) that they should not
-    if (!ignore)
+    if (!ignore) {
+#if ARCH_PORTDUINO
+        // In pipeline mode decrypting and decoding happen on another thread, runOnce() picks the packet up afterwards
+        if (packetPipeline && isDecodeAllowed(p)) {
+            p->rx_time = getValidTime(RTCQualityFromNet); // store the arrival timestamp for the phone
+            if (packetPipeline->submitForDecode(p))
+                return;
+        }
+#endif
         handleReceived(p);
+    }
 
     packetPool.release(p);
 }
\ No newline at end of file
@@ -18,6 +18,12 @@ class Router : protected concurrency::OSThread
     /// forwarded to the phone.
     PointerQueue<meshtastic_MeshPacket> fromRadioQueue;
 
+    /// The packet handleReceived is currently working on, exactly as it came off the air (i.e. still encrypted), or NULL
+    const meshtastic_MeshPacket *rxEncrypted = NULL;
+
+    /// Snapshot of the decoded payload of rxEncrypted, so we can tell if a module altered it
+    meshtastic_Data_payload_t rxPayload;
+
   protected:
     RadioInterface *iface = NULL;
 
@@ -101,6 +107,12 @@ class Router : protected concurrency::OSThread
      */
     virtual void sniffReceived(const meshtastic_MeshPacket *p, const meshtastic_Routing *c);
 
+    /**
+     * If p is the packet we are currently handling and no module altered its payload, return the original encrypted packet
+     * it was decoded from (so it can be forwarded without encrypting it all over again).  Otherwise return NULL.
+     */
+    const meshtastic_MeshPacket *getReceivedEncrypted(const meshtastic_MeshPacket *p);
+
     /**
      * Send an ack or a nak packet back towards whoever sent idFrom
      */
@@ -128,6 +140,12 @@ class Router : protected concurrency::OSThread
      */
     void handleReceived(meshtastic_MeshPacket *p, RxSource src = RX_SRC_RADIO);
 
+    /**
+     * The second half of handleReceived(), once perhapsDecode() has run: give the packet to the modules and MQTT.
+     * p_encrypted is a copy of p from before it was decoded.  Neither packet is freed.
+     */
+    void dispatchReceived(meshtastic_MeshPacket *p, const meshtastic_MeshPacket *p_encrypted, bool decoded, RxSource src);
+
     /** Frees the provided packet, and generates a NAK indicating the speicifed error while sending */
     void abortSendAndNak(meshtastic_Routing_Error err, meshtastic_MeshPacket *p);
 };
@@ -139,6 +157,17 @@ class Router : protected concurrency::OSThread
  */
 bool perhapsDecode(meshtastic_MeshPacket *p);
 
+/** Return false if our rebroadcast mode says we should not even try to decode this packet */
+bool isDecodeAllowed(const meshtastic_MeshPacket *p);
+
+/** The part of perhapsDecode() after isDecodeAllowed(): find a channel whose key decrypts p and decode it in place.
+ * Only touches the channel table and crypto engine (under cryptLock), so it is safe to call off the main loop.  Off the main
+ * loop it skips the "decoded message" log and JSON trace (the JSON can look up nodes), the caller logs those on the main loop.
+ *
+ * @return true for success, false for corrupt packet.
+ */
+bool decryptAndDecode(meshtastic_MeshPacket *p);
+
 /** Return 0 for success or a Routing_Errror code for failure
  */
 meshtastic_Routing_Error perhapsEncode(meshtastic_MeshPacket *p);
@@ -2,11 +2,21 @@
 #include "PowerFSM.h"
 #include "RTC.h"
 #include "configuration.h"
+#include <algorithm>
 
 #define START1 0x94
 #define START2 0xc3
 #define HEADER_LEN 4
 
+/// Fill in the 4 byte header in front of a len byte packet
+static void writeHeader(uint8_t *buf, size_t len)
+{
+    buf[0] = START1;
+    buf[1] = START2;
+    buf[2] = (len >> 8) & 0xff;
+    buf[3] = len & 0xff;
+}
+
 int32_t StreamAPI::runOncePart()
 {
     auto result = readStream();
@@ -26,48 +36,19 @@ int32_t StreamAPI::readStream()
         bool recentRx = (now - lastRxMsec) < 2000;
         return recentRx ? 5 : 250;
     } else {
-        while (stream->available()) { // Currently we never want to block
-            int cInt = stream->read();
-            if (cInt < 0)
+        int avail;
+        while ((avail = stream->available()) > 0) { // Currently we never want to block
+            // Take as much as we have room for in one go, rather than a call per byte
+            size_t want = std::min((size_t)avail, sizeof(rxBuf) - rxLen);
+            size_t got = readAvailable(rxBuf + rxLen, want);
+            if (got == 0)
                 break; // We ran out of characters (even though available said otherwise) - this can happen on rf52 adafruit
                        // arduino
+            rxLen += got;
 
-            uint8_t c = (uint8_t)cInt;
-
-            // Use the read pointer for a little state machine, first look for framing, then length bytes, then payload
-            size_t ptr = rxPtr;
-
-            rxPtr++;        // assume we will probably advance the rxPtr
-            rxBuf[ptr] = c; // store all bytes (including framing)
-
-            // console->printf("rxPtr %d ptr=%d c=0x%x\n", rxPtr, ptr, c);
-
-            if (ptr == 0) { // looking for START1
-                if (c != START1)
-                    rxPtr = 0;     // failed to find framing
-            } else if (ptr == 1) { // looking for START2
-                if (c != START2)
-                    rxPtr = 0;                             // failed to find framing
-            } else if (ptr >= HEADER_LEN - 1) {            // we have at least read our 4 byte framing
-                uint32_t len = (rxBuf[2] << 8) + rxBuf[3]; // big endian 16 bit length follows framing
-
-                // console->printf("len %d\n", len);
-
-                if (ptr == HEADER_LEN - 1) {
-                    // we _just_ finished our 4 byte header, validate length now (note: a length of zero is a valid
-                    // protobuf also)
-                    if (len > MAX_TO_FROM_RADIO_SIZE)
-                        rxPtr = 0; // length is bogus, restart search for framing
-                }
-
-                if (rxPtr != 0)                        // Is packet still considered 'good'?
-                    if (ptr + 1 >= len + HEADER_LEN) { // have we received all of the payload?
-                        rxPtr = 0;                     // start over again on the next packet
-
-                        // If we didn't just fail the packet and we now have the right # of bytes, parse it
-                        handleToRadio(rxBuf + HEADER_LEN, len);
-                    }
-            }
+            size_t consumed = parseRxBuf();
+            memmove(rxBuf, rxBuf + consumed, rxLen - consumed); // keep any partial packet for next time
+            rxLen -= consumed;
         }
 
         // we had bytes available this time, so assume we might have them next time also
@@ -76,6 +57,54 @@ int32_t StreamAPI::readStream()
     }
 }
 
+size_t StreamAPI::readAvailable(uint8_t *buf, size_t len)
+{
+    size_t got = 0;
+    int c;
+    while (got < len && (c = stream->read()) >= 0)
+        buf[got++] = c;
+    return got;
+}
+
+/**
+ * Hand every complete packet in rxBuf to handleToRadio (straight from the buffer), skipping anything that isn't validly framed.
+ * Returns how many bytes at the start of rxBuf we are done with.
+ */
+size_t StreamAPI::parseRxBuf()
+{
+    size_t pos = 0;
+    while (pos < rxLen) {
+        // look for START1
+        uint8_t *start = (uint8_t *)memchr(rxBuf + pos, START1, rxLen - pos);
+        if (!start)
+            return rxLen; // failed to find framing, none of this is any use
+        pos = start - rxBuf;
+
+        size_t left = rxLen - pos;
+        if (left < 2)
+            break; // need more bytes to check START2
+        if (rxBuf[pos + 1] != START2) {
+            pos++; // failed to find framing
+            continue;
+        }
+        if (left < HEADER_LEN)
+            break;
+
+        uint32_t len = (rxBuf[pos + 2] << 8) + rxBuf[pos + 3]; // big endian 16 bit length follows framing
+        // validate length now (note: a length of zero is a valid protobuf also)
+        if (len > MAX_TO_FROM_RADIO_SIZE) {
+            pos++; // length is bogus, restart search for framing
+            continue;
+        }
+        if (left < HEADER_LEN + len)
+            break; // have not received all of the payload yet
+
+        handleToRadio(rxBuf + pos + HEADER_LEN, len);
+        pos += HEADER_LEN + len;
+    }
+    return pos;
+}
+
 /**
  * call getFromRadio() and deliver encapsulated packets to the Stream
  */
@@ -84,10 +113,29 @@ void StreamAPI::writeStream()
     if (canWrite) {
         uint32_t len;
         do {
-            // Send every packet we can
-            len = getFromRadio(txBuf + HEADER_LEN);
-            emitTxBuffer(len);
+            // Send every packet we can, framing them straight into the batch and only writing it out once it might not hold
+            // another one (a want_config download is hundreds of small packets, so this saves a write + flush for each)
+            if (txBatchLen + MAX_STREAM_BUF_SIZE > STREAM_TX_BATCH_SIZE)
+                flushTxBatch();
+
+            uint8_t *batch = getTxBatch();
+            len = getFromRadio(batch + txBatchLen + HEADER_LEN);
+            if (len) {
+                writeHeader(batch + txBatchLen, len);
+                txBatchLen += len + HEADER_LEN;
+            }
         } while (len);
+
+        flushTxBatch(); // nothing else to send for now
+    }
+}
+
+void StreamAPI::flushTxBatch()
+{
+    if (txBatchLen) {
+        stream->write(getTxBatch(), txBatchLen);
+        stream->flush();
+        txBatchLen = 0;
     }
 }
 
@@ -97,10 +145,7 @@ void StreamAPI::writeStream()
 void StreamAPI::emitTxBuffer(size_t len)
 {
     if (len != 0) {
-        txBuf[0] = START1;
-        txBuf[1] = START2;
-        txBuf[2] = (len >> 8) & 0xff;
-        txBuf[3] = len & 0xff;
+        writeHeader(txBuf, len);
 
         auto totalLen = len + HEADER_LEN;
         stream->write(txBuf, totalLen);
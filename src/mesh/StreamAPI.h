@@ -7,6 +7,26 @@
 // A To/FromRadio packet + our 32 bit header
 #define MAX_STREAM_BUF_SIZE (MAX_TO_FROM_RADIO_SIZE + sizeof(uint32_t))
 
+// readStream() pulls whatever has arrived into a buffer this big, and parses every complete packet in it in place
+#ifndef STREAM_RX_BUF_SIZE
+#if defined(ARCH_PORTDUINO)
+#define STREAM_RX_BUF_SIZE (4 * 1024)
+#else
+#define STREAM_RX_BUF_SIZE MAX_STREAM_BUF_SIZE
+#endif
+#endif
+
+// writeStream() packs as many framed FromRadio packets as fit in this much buffer into each write to the stream
+#ifndef STREAM_TX_BATCH_SIZE
+#if defined(ARCH_PORTDUINO)
+#define STREAM_TX_BATCH_SIZE (8 * 1024)
+#elif defined(ARCH_ESP32)
+#define STREAM_TX_BATCH_SIZE (2 * 1024)
+#else
+#define STREAM_TX_BATCH_SIZE MAX_STREAM_BUF_SIZE // one packet per write, RAM is tight
+#endif
+#endif
+
 /**
  * A version of our 'phone' API that talks over a Stream.  So therefore well suited to use with serial links
  * or TCP connections.
@@ -35,12 +55,24 @@ class StreamAPI : public PhoneAPI
      */
     Stream *stream;
 
-    uint8_t rxBuf[MAX_STREAM_BUF_SIZE] = {0};
-    size_t rxPtr = 0;
+    /// Bytes read from the stream but not handled yet, always starting at a (possible) packet header
+    uint8_t rxBuf[STREAM_RX_BUF_SIZE] = {0};
+    size_t rxLen = 0;
+    static_assert(STREAM_RX_BUF_SIZE >= MAX_STREAM_BUF_SIZE, "STREAM_RX_BUF_SIZE must hold at least one packet");
 
     /// time of last rx, used, to slow down our polling if we haven't heard from anyone
     uint32_t lastRxMsec = 0;
 
+    /// Does the batch need a buffer of its own?  A batch of one packet just uses txBuf, rather than spend another
+    /// MAX_STREAM_BUF_SIZE of RAM on the targets that can least afford it.  (MAX_STREAM_BUF_SIZE has a sizeof in it, so this
+    /// can't be an #if)
+    static constexpr bool ownTxBatch = STREAM_TX_BATCH_SIZE > MAX_STREAM_BUF_SIZE;
+
+    /// Framed packets writeStream() has yet to hand to the stream, only a placeholder byte when the batch lives in txBuf
+    uint8_t txBatch[ownTxBatch ? STREAM_TX_BATCH_SIZE : 1];
+    size_t txBatchLen = 0;
+    static_assert(STREAM_TX_BATCH_SIZE >= MAX_STREAM_BUF_SIZE, "STREAM_TX_BATCH_SIZE must hold at least one packet");
+
   public:
     StreamAPI(Stream *_stream) : stream(_stream) {}
 
@@ -56,11 +88,19 @@ class StreamAPI : public PhoneAPI
      */
     int32_t readStream();
 
+    /// Handle the complete packets in rxBuf, @return how many bytes of it were used up
+    size_t parseRxBuf();
+
     /**
      * call getFromRadio() and deliver encapsulated packets to the Stream
      */
     void writeStream();
 
+    /// Write out (and flush) everything in txBatch
+    void flushTxBatch();
+
+    uint8_t *getTxBatch() { return ownTxBatch ? txBatch : txBuf; }
+
   protected:
     /**
      * Send a FromRadio.rebooted = true packet to the phone
@@ -72,6 +112,13 @@ class StreamAPI : public PhoneAPI
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override = 0;
 
+    /**
+     * Copy up to len bytes the stream already has into buf without waiting, @return how many.  Stream has no bulk read that
+     * doesn't block (readBytes() waits out a timeout), so by default this calls read() a byte at a time - subclasses whose
+     * stream has a real buffer to copy from should override it.
+     */
+    virtual size_t readAvailable(uint8_t *buf, size_t len);
+
     /**
      * Send the current txBuffer over our stream
      */
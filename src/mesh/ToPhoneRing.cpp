@@ -0,0 +1,67 @@
+#include "ToPhoneRing.h"
+#include "concurrency/LockGuard.h"
+#include "configuration.h"
+
+/// Wrap safe a < b for sequence numbers
+static bool seqBefore(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+ToPhoneRing::~ToPhoneRing()
+{
+    for (uint32_t seq = tail; seq != head; seq++)
+        packetPool.release(slots[seq % MAX_RX_TOPHONE]);
+}
+
+void ToPhoneRing::push(meshtastic_MeshPacket *p)
+{
+    concurrency::LockGuard guard(&lock);
+    if (head - tail == MAX_RX_TOPHONE) {
+        if (!seqBefore(tail, delivered)) {
+            LOG_WARN("ToPhone queue is full, discarding oldest\n");
+            dropped++;
+        }
+        packetPool.release(slots[tail % MAX_RX_TOPHONE]);
+        tail++;
+        if (seqBefore(delivered, tail))
+            delivered = tail;
+    }
+
+    slots[head % MAX_RX_TOPHONE] = p;
+    head++;
+}
+
+void ToPhoneRing::attach(Cursor &c)
+{
+    concurrency::LockGuard guard(&lock);
+    if (!c.attached) {
+        c.next = delivered;
+        c.attached = true;
+    }
+}
+
+meshtastic_MeshPacket *ToPhoneRing::take(Cursor &c)
+{
+    concurrency::LockGuard guard(&lock);
+    if (seqBefore(c.next, tail)) {
+        uint32_t gap = tail - c.next;
+        LOG_WARN("Phone client fell %u packets behind, skipping them\n", gap);
+        c.missed += gap;
+        c.next = tail;
+    }
+    if (c.next == head)
+        return NULL;
+
+    meshtastic_MeshPacket *p = packetPool.share(slots[c.next % MAX_RX_TOPHONE]);
+    c.next++;
+    if (seqBefore(delivered, c.next))
+        delivered = c.next;
+    return p;
+}
+
+bool ToPhoneRing::allDelivered()
+{
+    concurrency::LockGuard guard(&lock);
+    return delivered == head;
+}
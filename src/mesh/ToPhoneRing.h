@@ -0,0 +1,61 @@
+#pragma once
+
+#include "MeshTypes.h"
+#include "concurrency/Lock.h"
+#include "mesh-pb-constants.h"
+
+/**
+ * The received packets waiting for the phone(s).
+ *
+ * Every packet gets the next sequence number and stays in the ring until MAX_RX_TOPHONE newer ones have arrived, at which
+ * point the oldest is dropped.  Each client (PhoneAPI) reads with its own Cursor and gets a shared reference to the packet
+ * (see MemoryPool::share()), so serial, TCP and BLE clients all see every packet instead of splitting them between them, and
+ * no client gets a copy of its own.
+ *
+ * A client that reconnects keeps its cursor, so it resumes right after the last packet it saw, as long as that is still
+ * in the ring.  A client that fell further behind than that skips ahead, and the gap is counted.
+ */
+class ToPhoneRing
+{
+  public:
+    /// How far one client has read, owned by the client
+    struct Cursor {
+        uint32_t next = 0;     // sequence number of the next packet this client wants
+        uint32_t missed = 0;   // packets dropped from the ring before this client read them
+        bool attached = false; // false until the client first asks for packets
+    };
+
+    ToPhoneRing() {}
+
+    /// Releases every packet still held
+    ~ToPhoneRing();
+
+    /// Add p (we take over the caller's reference), dropping the oldest packet if the ring is full
+    void push(meshtastic_MeshPacket *p);
+
+    /**
+     * Start a new client at the first packet no client has read yet.  A client that is already attached keeps its place, so
+     * it picks up where it left off.
+     */
+    void attach(Cursor &c);
+
+    /// The next packet for this client, or NULL if it is caught up.  The client must release it to packetPool
+    meshtastic_MeshPacket *take(Cursor &c);
+
+    /// True if every packet has been read by at least one client
+    bool allDelivered();
+
+    /// Number of packets dropped before any client read them
+    uint32_t getDropped() const { return dropped; }
+
+  private:
+    meshtastic_MeshPacket *slots[MAX_RX_TOPHONE] = {};
+
+    uint32_t head = 0;      // sequence number the next packet will get
+    uint32_t tail = 0;      // sequence number of the oldest packet we still hold
+    uint32_t delivered = 0; // every packet before this one has been read by some client, never behind tail
+    uint32_t dropped = 0;
+
+    /// BLE clients read from their own task
+    concurrency::Lock lock;
+};
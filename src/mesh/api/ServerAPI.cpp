@@ -25,6 +25,12 @@ template <typename T> bool ServerAPI<T>::checkIsConnected()
     return client.connected();
 }
 
+template <typename T> size_t ServerAPI<T>::readAvailable(uint8_t *buf, size_t len)
+{
+    int got = client.read(buf, len);
+    return got > 0 ? got : 0;
+}
+
 template <class T> int32_t ServerAPI<T>::runOnce()
 {
     if (client.connected()) {
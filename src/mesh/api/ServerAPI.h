@@ -28,6 +28,9 @@ template <class T> class ServerAPI : public StreamAPI, private concurrency::OSTh
 
     /// Check the current underlying physical link to see if the client is currently connected
     virtual bool checkIsConnected() override;
+
+    /// Client has a real bulk read, unlike Stream
+    virtual size_t readAvailable(uint8_t *buf, size_t len) override;
 };
 
 /**
@@ -3,11 +3,29 @@
 
 #if HAS_WIFI
 #include "WiFiServerAPI.h"
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/EpollServerAPI.h"
+#endif
 
 static WiFiServerPort *apiPort;
+#ifdef ARCH_PORTDUINO
+static EpollServerPort *epollPort;
+#endif
 
 void initApiServer(int port)
 {
+#ifdef ARCH_PORTDUINO
+    // meshtasticd can serve several clients at once, only fall back to the single client server if that can't start
+    if (epollPort)
+        return; // already listening
+    if (!apiPort) {
+        epollPort = EpollServerPort::start(port);
+        if (epollPort) {
+            LOG_INFO("API server listening on TCP port %d, up to %d clients\n", port, EPOLL_API_MAX_CLIENTS);
+            return;
+        }
+    }
+#endif
     // Start API server on port 4403
     if (!apiPort) {
         apiPort = new WiFiServerPort(port);
@@ -17,6 +35,10 @@ void initApiServer(int port)
 }
 void deInitApiServer()
 {
+#ifdef ARCH_PORTDUINO
+    delete epollPort;
+    epollPort = NULL;
+#endif
     delete apiPort;
 }
 
@@ -1,8 +1,10 @@
 #if !MESHTASTIC_EXCLUDE_WEBSERVER
+#include "MeshService.h"
 #include "NodeDB.h"
 #include "PowerFSM.h"
 #include "RadioLibInterface.h"
 #include "airtime.h"
+#include "concurrency/OSThread.h"
 #include "main.h"
 #include "mesh/http/ContentHelper.h"
 #include "mesh/http/WebServer.h"
@@ -634,6 +636,12 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjMemory["fs_total"] = new JSONValue((int)FSCom.totalBytes());
     jsonObjMemory["fs_used"] = new JSONValue((int)FSCom.usedBytes());
     jsonObjMemory["fs_free"] = new JSONValue(int(FSCom.totalBytes() - FSCom.usedBytes()));
+    const NodeDB::PersistStats &persistStats = nodeDB->getPersistStats();
+    jsonObjMemory["fs_proto_writes"] = new JSONValue((int)persistStats.protoWrites);
+    jsonObjMemory["fs_proto_bytes"] = new JSONValue((int)persistStats.protoBytes);
+    jsonObjMemory["fs_journal_records"] = new JSONValue((int)persistStats.journalRecords);
+    jsonObjMemory["fs_journal_bytes"] = new JSONValue((int)persistStats.journalBytes);
+    jsonObjMemory["tophone_dropped"] = new JSONValue((int)service.getToPhoneDropped());
 
     // data->power
     JSONObject jsonObjPower;
@@ -652,6 +660,28 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjRadio["frequency"] = new JSONValue(RadioLibInterface::instance->getFreq());
     jsonObjRadio["lora_channel"] = new JSONValue((int)RadioLibInterface::instance->getChannelNum() + 1);
 
+    // data->threads
+    JSONObject jsonObjThreads;
+    for (int i = 0; i < MAX_THREADS; i++) {
+        auto thread = static_cast<concurrency::OSThread *>(concurrency::mainController.get(i));
+        if (!thread)
+            continue;
+        const concurrency::ThreadStats &st = thread->getStats();
+        JSONArray histogramValues;
+        for (int j = 0; j < THREAD_STATS_BUCKETS; j++)
+            histogramValues.push_back(new JSONValue((int)st.histogram[j]));
+
+        JSONObject jsonObjThread;
+        jsonObjThread["enabled"] = new JSONValue(BoolToString(thread->enabled));
+        jsonObjThread["runs"] = new JSONValue((int)st.runs);
+        jsonObjThread["total_msec"] = new JSONValue((int)(st.totalUsec / 1000));
+        jsonObjThread["max_usec"] = new JSONValue((int)st.maxUsec);
+        jsonObjThread["total_late_msec"] = new JSONValue((int)st.totalLateMsec);
+        jsonObjThread["max_late_msec"] = new JSONValue((int)st.maxLateMsec);
+        jsonObjThread["histogram"] = new JSONValue(histogramValues);
+        jsonObjThreads[thread->ThreadName.c_str()] = new JSONValue(jsonObjThread);
+    }
+
     // collect data to inner data object
     JSONObject jsonObjInner;
     jsonObjInner["airtime"] = new JSONValue(jsonObjAirtime);
@@ -660,6 +690,7 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjInner["power"] = new JSONValue(jsonObjPower);
     jsonObjInner["device"] = new JSONValue(jsonObjDevice);
     jsonObjInner["radio"] = new JSONValue(jsonObjRadio);
+    jsonObjInner["threads"] = new JSONValue(jsonObjThreads);
 
     // create json output structure
     JSONObject jsonObjOuter;
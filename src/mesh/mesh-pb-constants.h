@@ -21,6 +21,9 @@
 #define MAX_NUM_NODES 100
 #endif
 
+/// NodeDB numbers its node slots with a uint16_t, UINT16_MAX marks an empty index bucket, so it can't hold more than this
+#define NODEDB_MAX_SLOTS 65534
+
 /// Max number of channels allowed
 #define MAX_NUM_CHANNELS (member_size(meshtastic_ChannelFile, channels) / member_size(meshtastic_ChannelFile, channels[0]))
 
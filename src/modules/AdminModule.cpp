@@ -858,7 +858,7 @@ void AdminModule::saveChanges(int saveWhat, bool shouldReboot)
 {
     if (!hasOpenEditTransaction) {
         LOG_INFO("Saving changes to disk\n");
-        service.reloadConfig(saveWhat); // Calls saveToDisk among other things
+        service.reloadConfig(saveWhat); // Calls saveToDiskLater among other things
     } else {
         LOG_INFO("Delaying save of changes to disk until the open transaction is committed\n");
     }
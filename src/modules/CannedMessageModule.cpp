@@ -8,6 +8,7 @@
 #include "FSCommon.h"
 #include "MeshService.h"
 #include "NodeDB.h"
+#include "PayloadCache.h"
 #include "PowerFSM.h" // needed for button bypass
 #include "detect/ScanI2C.h"
 #include "mesh/generated/meshtastic/cannedmessages.pb.h"
@@ -677,7 +678,7 @@ const char *CannedMessageModule::getNodeName(NodeNum node)
     if (node == NODENUM_BROADCAST) {
         return "Broadcast";
     } else {
-        meshtastic_NodeInfoLite *info = nodeDB->getMeshNode(node);
+        const meshtastic_NodeInfoLite *info = nodeDB->getMeshNode(node);
         if (info != NULL) {
             return info->user.long_name;
         } else {
@@ -1050,7 +1051,7 @@ ProcessMessage CannedMessageModule::handleReceived(const meshtastic_MeshPacket &
             this->runState = CANNED_MESSAGE_RUN_STATE_ACK_NACK_RECEIVED;
             this->incoming = service.getNodenumFromRequestId(mp.decoded.request_id);
             meshtastic_Routing decoded = meshtastic_Routing_init_default;
-            pb_decode_from_bytes(mp.decoded.payload.bytes, mp.decoded.payload.size, meshtastic_Routing_fields, &decoded);
+            PayloadCache::decode(mp, meshtastic_Routing_fields, decoded);
             this->ack = decoded.error_reason == meshtastic_Routing_Error_NONE;
             waitingForAck = false; // No longer want routing packets
             this->notifyObservers(&e);
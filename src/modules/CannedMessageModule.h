@@ -88,6 +88,9 @@ class CannedMessageModule : public SinglePortModule, public Observable<const UIF
         }
     }
 
+    /// wantPacket() also tracks the last rx rssi/snr, so it must see every packet
+    virtual bool mayWantPortNum(meshtastic_PortNum portnum) override { return true; }
+
   protected:
     virtual int32_t runOnce() override;
 
@@ -986,6 +986,11 @@ bool DzhagaModule::wantPacket(const meshtastic_MeshPacket *p)
     return MeshService::isTextPayload(p);
 }
 
+bool DzhagaModule::mayWantPortNum(meshtastic_PortNum portnum)
+{
+    return MeshService::isTextPortNum(portnum);
+}
+
 
 
 /// Find a node in our DB, return null for missing
@@ -32,6 +32,7 @@ class DzhagaModule : public SinglePortModule, private concurrency::OSThread
     virtual int32_t runOnce() override;
 
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override;
+    virtual bool mayWantPortNum(meshtastic_PortNum portnum) override;
 
   protected:
     bool firstTime = true;
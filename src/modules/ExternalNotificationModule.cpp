@@ -195,6 +195,11 @@ bool ExternalNotificationModule::wantPacket(const meshtastic_MeshPacket *p)
     return MeshService::isTextPayload(p);
 }
 
+bool ExternalNotificationModule::mayWantPortNum(meshtastic_PortNum portnum)
+{
+    return MeshService::isTextPortNum(portnum);
+}
+
 /**
  * Sets the external notification on for the specified index.
  *
@@ -56,6 +56,7 @@ class ExternalNotificationModule : public SinglePortModule, private concurrency:
     virtual int32_t runOnce() override;
 
     virtual bool wantPacket(const meshtastic_MeshPacket *p) override;
+    virtual bool mayWantPortNum(meshtastic_PortNum portnum) override;
 
     bool isNagging = false;
 
@@ -26,7 +26,7 @@ bool NodeInfoModule::handleReceivedProtobuf(const meshtastic_MeshPacket &mp, mes
 
     // if user has changed while packet was not for us, inform phone
     if (hasChanged && !wasBroadcast && mp.to != nodeDB->getNodeNum())
-        service.sendToPhone(packetPool.allocCopy(mp));
+        service.sendToPhone(packetPool.share(&mp));
 
     // LOG_DEBUG("did handleReceived\n");
     return false; // Let others look at this message also if they want
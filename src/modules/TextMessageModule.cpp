@@ -26,4 +26,9 @@ ProcessMessage TextMessageModule::handleReceived(const meshtastic_MeshPacket &mp
 bool TextMessageModule::wantPacket(const meshtastic_MeshPacket *p)
 {
     return MeshService::isTextPayload(p);
+}
+
+bool TextMessageModule::mayWantPortNum(meshtastic_PortNum portnum)
+{
+    return MeshService::isTextPortNum(portnum);
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "TraceRouteModule.h"
 #include "MeshService.h"
+#include "PayloadCache.h"
 
 TraceRouteModule *traceRouteModule;
 
@@ -79,11 +80,9 @@ meshtastic_MeshPacket *TraceRouteModule::allocReply()
 
     // Copy the payload of the current request
     auto req = *currentRequest;
-    const auto &p = req.decoded;
     meshtastic_RouteDiscovery scratch;
     meshtastic_RouteDiscovery *updated = NULL;
-    memset(&scratch, 0, sizeof(scratch));
-    pb_decode_from_bytes(p.payload.bytes, p.payload.size, &meshtastic_RouteDiscovery_msg, &scratch);
+    PayloadCache::decode(req, &meshtastic_RouteDiscovery_msg, scratch);
     updated = &scratch;
 
     printRoute(updated, req.from, req.to);
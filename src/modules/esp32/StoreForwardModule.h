@@ -78,6 +78,11 @@ class StoreForwardModule : private concurrency::OSThread, public ProtobufModule<
         }
     }
 
+    virtual bool mayWantPortNum(meshtastic_PortNum portnum) override
+    {
+        return portnum == meshtastic_PortNum_TEXT_MESSAGE_APP || portnum == meshtastic_PortNum_STORE_FORWARD_APP;
+    }
+
   private:
     void populatePSRAM();
 
@@ -218,6 +218,7 @@ MQTT::MQTT() : concurrency::OSThread("mqtt"), mqttQueue(MAX_MQTT_QUEUE)
         if (moduleConfig.mqtt.proxy_to_client_enabled) {
             LOG_INFO("MQTT configured to use client proxy...\n");
             enabled = true;
+            setInterval(0);
             runASAP = true;
             reconnectCount = 0;
             publishNodeInfo();
@@ -282,6 +283,7 @@ void MQTT::reconnect()
         if (moduleConfig.mqtt.proxy_to_client_enabled) {
             LOG_INFO("MQTT connecting via client proxy instead...\n");
             enabled = true;
+            setInterval(0);
             runASAP = true;
             reconnectCount = 0;
 
@@ -338,6 +340,7 @@ void MQTT::reconnect()
         if (connected) {
             LOG_INFO("MQTT connected\n");
             enabled = true; // Start running background process again
+            setInterval(0);
             runASAP = true;
             reconnectCount = 0;
 
@@ -398,6 +401,14 @@ bool MQTT::wantsLink() const
 }
 
 int32_t MQTT::runOnce()
+{
+    concurrency::LockGuard guard(&clientLock);
+    int32_t delay = pollClient();
+    connectedDirectly = isConnectedDirectly();
+    return delay;
+}
+
+int32_t MQTT::pollClient()
 {
 #if HAS_NETWORKING
     if (!moduleConfig.mqtt.enabled || !(moduleConfig.mqtt.map_reporting_enabled || channels.anyMqttEnabled()))
@@ -470,80 +481,130 @@ void MQTT::publishQueuedMessages()
             }
         }
 #endif // ARCH_NRF52
+        packetPool.release(env->packet);
         mqttPool.release(env);
     }
 }
 
 void MQTT::onSend(const meshtastic_MeshPacket &mp, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex)
+{
+    MQTTUplink uplink;
+    if (!prepareSend(mp, mp_decoded, chIndex, uplink))
+        return;
+    if (canPublishNow())
+        addJson(mp_decoded, uplink); // a queued packet gets its JSON when the queue drains
+    finishSend(uplink, true);
+}
+
+bool MQTT::prepareSend(const meshtastic_MeshPacket &mp, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex,
+                       MQTTUplink &uplink)
 {
     if (mp.via_mqtt)
-        return; // Don't send messages that came from MQTT back into MQTT
+        return false; // Don't send messages that came from MQTT back into MQTT
 
     auto &ch = channels.getByIndex(chIndex);
 
     if (mp_decoded.which_payload_variant != meshtastic_MeshPacket_decoded_tag) {
         LOG_CRIT("MQTT::onSend(): mp_decoded isn't actually decoded\n");
-        return;
+        return false;
     }
 
     if (strcmp(moduleConfig.mqtt.address, default_mqtt_address) == 0 &&
         (mp_decoded.decoded.portnum == meshtastic_PortNum_RANGE_TEST_APP ||
          mp_decoded.decoded.portnum == meshtastic_PortNum_DETECTION_SENSOR_APP)) {
         LOG_DEBUG("MQTT onSend - Ignoring range test or detection sensor message on public mqtt\n");
-        return;
+        return false;
     }
 
-    if (ch.settings.uplink_enabled) {
-        const char *channelId = channels.getGlobalId(chIndex); // FIXME, for now we just use the human name for the channel
+    if (!ch.settings.uplink_enabled)
+        return false;
 
-        meshtastic_ServiceEnvelope *env = mqttPool.allocZeroed();
-        env->channel_id = (char *)channelId;
-        env->gateway_id = owner.id;
+    uplink.channelId = channels.getGlobalId(chIndex); // FIXME, for now we just use the human name for the channel
+    uplink.gatewayId = owner.id;
+    uplink.chIndex = chIndex;
 
-        LOG_DEBUG("MQTT onSend - Publishing ");
-        if (moduleConfig.mqtt.encryption_enabled) {
-            env->packet = (meshtastic_MeshPacket *)&mp;
-            LOG_DEBUG("encrypted message\n");
-        } else {
-            env->packet = (meshtastic_MeshPacket *)&mp_decoded;
-            LOG_DEBUG("portnum %i message\n", env->packet->decoded.portnum);
-        }
+    LOG_DEBUG("MQTT onSend - Publishing ");
+    if (moduleConfig.mqtt.encryption_enabled) {
+        uplink.packet = &mp;
+        LOG_DEBUG("encrypted message\n");
+    } else {
+        uplink.packet = &mp_decoded;
+        LOG_DEBUG("portnum %i message\n", mp_decoded.decoded.portnum);
+    }
 
-        if (moduleConfig.mqtt.proxy_to_client_enabled || this->isConnectedDirectly()) {
-            // FIXME - this size calculation is super sloppy, but it will go away once we dynamically alloc meshpackets
-            static uint8_t bytes[meshtastic_MeshPacket_size + 64];
-            size_t numBytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_ServiceEnvelope_msg, env);
+    uplink.json.clear();
+    return true;
+}
 
-            std::string topic = cryptTopic + channelId + "/" + owner.id;
-            LOG_DEBUG("MQTT Publish %s, %u bytes\n", topic.c_str(), numBytes);
+bool MQTT::canPublishNow() const
+{
+    return moduleConfig.mqtt.proxy_to_client_enabled || connectedDirectly;
+}
 
+void MQTT::addJson(const meshtastic_MeshPacket &mp_decoded, MQTTUplink &uplink)
+{
+#ifndef ARCH_NRF52 // JSON is not supported on nRF52, see issue #2804
+    // The JSON has node names in it, so it is made here rather than wherever finishSend() runs
+    if (moduleConfig.mqtt.json_enabled)
+        uplink.json = MeshPacketSerializer::JsonSerialize((meshtastic_MeshPacket *)&mp_decoded);
+#endif
+}
+
+void MQTT::finishSend(MQTTUplink &uplink, bool onMainLoop)
+{
+    // The main loop can't take clientLock here, a downlink sent from inside pubSub.loop() comes back through onSend() with it
+    // held.  Going by what the last runOnce() saw instead is fine there, as the main loop is the only one that changes it.
+    bool viaProxy = onMainLoop && moduleConfig.mqtt.proxy_to_client_enabled; // the proxy goes through MeshService
+    bool direct = onMainLoop ? connectedDirectly : this->isConnectedDirectly();
+    if (viaProxy || direct) {
+        meshtastic_ServiceEnvelope env = meshtastic_ServiceEnvelope_init_zero;
+        env.channel_id = (char *)uplink.channelId.c_str();
+        env.gateway_id = (char *)uplink.gatewayId.c_str();
+        env.packet = (meshtastic_MeshPacket *)uplink.packet;
+
+        // FIXME - this size calculation is super sloppy, but it will go away once we dynamically alloc meshpackets
+        static uint8_t bytes[meshtastic_MeshPacket_size + 64];
+        size_t numBytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_ServiceEnvelope_msg, &env);
+
+        std::string topic = cryptTopic + uplink.channelId + "/" + uplink.gatewayId;
+        LOG_DEBUG("MQTT Publish %s, %u bytes\n", topic.c_str(), numBytes);
+
+        if (onMainLoop)
             publish(topic.c_str(), bytes, numBytes, false);
+#if HAS_NETWORKING
+        else
+            pubSub.publish(topic.c_str(), bytes, numBytes, false); // publish() could pick the proxy, which is main loop only
+#endif
 
-#ifndef ARCH_NRF52 // JSON is not supported on nRF52, see issue #2804
-            if (moduleConfig.mqtt.json_enabled) {
-                // handle json topic
-                auto jsonString = MeshPacketSerializer::JsonSerialize((meshtastic_MeshPacket *)&mp_decoded);
-                if (jsonString.length() != 0) {
-                    std::string topicJson = jsonTopic + channelId + "/" + owner.id;
-                    LOG_INFO("JSON publish message to %s, %u bytes: %s\n", topicJson.c_str(), jsonString.length(),
-                             jsonString.c_str());
-                    publish(topicJson.c_str(), jsonString.c_str(), false);
-                }
-            }
-#endif // ARCH_NRF52
-        } else {
-            LOG_INFO("MQTT not connected, queueing packet\n");
-            if (mqttQueue.numFree() == 0) {
-                LOG_WARN("NOTE: MQTT queue is full, discarding oldest\n");
-                meshtastic_ServiceEnvelope *d = mqttQueue.dequeuePtr(0);
-                if (d)
-                    mqttPool.release(d);
+        if (uplink.json.length() != 0) {
+            std::string topicJson = jsonTopic + uplink.channelId + "/" + uplink.gatewayId;
+            LOG_INFO("JSON publish message to %s, %u bytes: %s\n", topicJson.c_str(), uplink.json.length(), uplink.json.c_str());
+            if (onMainLoop)
+                publish(topicJson.c_str(), uplink.json.c_str(), false);
+#if HAS_NETWORKING
+            else
+                pubSub.publish(topicJson.c_str(), uplink.json.c_str(), false);
+#endif
+        }
+    } else if (!onMainLoop) {
+        // The offline queue needs channels and owner (and a copy of the packet) when it is filled, so leave it to the main loop
+        LOG_WARN("MQTT link went down, dropping packet 0x%x\n", uplink.packet->id);
+    } else {
+        LOG_INFO("MQTT not connected, queueing packet\n");
+        if (mqttQueue.numFree() == 0) {
+            LOG_WARN("NOTE: MQTT queue is full, discarding oldest\n");
+            meshtastic_ServiceEnvelope *d = mqttQueue.dequeuePtr(0);
+            if (d) {
+                packetPool.release(d->packet);
+                mqttPool.release(d);
             }
-            // make a copy of serviceEnvelope and queue it
-            meshtastic_ServiceEnvelope *copied = mqttPool.allocCopy(*env);
-            assert(mqttQueue.enqueue(copied, 0));
         }
-        mqttPool.release(env);
+        // The queue holds its own copy of the packet, the caller's is only borrowed until we return
+        meshtastic_ServiceEnvelope *queued = mqttPool.allocZeroed();
+        queued->channel_id = (char *)channels.getGlobalId(uplink.chIndex);
+        queued->gateway_id = owner.id;
+        queued->packet = packetPool.allocCopy(*uplink.packet);
+        assert(mqttQueue.enqueue(queued, 0));
     }
 }
 
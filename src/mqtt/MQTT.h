@@ -2,6 +2,7 @@
 
 #include "configuration.h"
 
+#include "concurrency/LockGuard.h"
 #include "concurrency/OSThread.h"
 #include "mesh/Channels.h"
 #include "mesh/generated/meshtastic/mqtt.pb.h"
@@ -22,6 +23,15 @@
 
 #define MAX_MQTT_QUEUE 16
 
+/// One uplink publish, with everything it needs from main loop state (channels, owner, NodeDB) captured by MQTT::prepareSend()
+struct MQTTUplink {
+    std::string channelId;
+    std::string gatewayId;
+    ChannelIndex chIndex;
+    const meshtastic_MeshPacket *packet; // encrypted or decoded as encryption_enabled says, not owned by us
+    std::string json;                    // empty unless json_enabled and MQTT::addJson() was called
+};
+
 /**
  * Our wrapper/singleton for sending/receiving MQTT "udp" packets.  This object isolates the MQTT protocol implementation from
  * the two components that use it: MQTTPlugin and MQTTSimInterface.
@@ -44,6 +54,10 @@ class MQTT : private concurrency::OSThread
 #if HAS_NETWORKING
     PubSubClient pubSub;
 #endif
+
+    /// Held by runOnce(), and by the portduino pipeline's egress thread around finishSend(), so they don't share pubSub at once
+    concurrency::Lock clientLock;
+
     MQTT();
 
     /**
@@ -57,6 +71,32 @@ class MQTT : private concurrency::OSThread
      */
     void onSend(const meshtastic_MeshPacket &mp, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex);
 
+    /**
+     * The main loop half of onSend(): apply the uplink filters and capture what the publish needs.  Returns false if this
+     * packet shouldn't go to MQTT.  uplink.packet points at mp or mp_decoded, which must outlive the finishSend() call.
+     */
+    bool prepareSend(const meshtastic_MeshPacket &mp, const meshtastic_MeshPacket &mp_decoded, ChannelIndex chIndex,
+                     MQTTUplink &uplink);
+
+    /**
+     * Add the JSON for mp_decoded to uplink, if json_enabled.  Main loop only (the JSON has node names in it), and only worth
+     * calling for an uplink that is about to be published rather than queued.
+     */
+    void addJson(const meshtastic_MeshPacket &mp_decoded, MQTTUplink &uplink);
+
+    /**
+     * Publish what prepareSend() captured.  Off the main loop (with clientLock held) only a direct publish to the server is
+     * allowed, proxy publishes and the offline queue are left to the main loop, and a packet that finds the link down there is
+     * dropped.
+     */
+    void finishSend(MQTTUplink &uplink, bool onMainLoop);
+
+    /// Whether the last runOnce() left us connected straight to the server, main loop only but doesn't need clientLock
+    bool wasConnectedDirectly() const { return connectedDirectly; }
+
+    /// Would finishSend() on the main loop publish right away, rather than queue?  Main loop only
+    bool canPublishNow() const;
+
     /** Attempt to connect to server if necessary
      */
     void reconnect();
@@ -81,6 +121,9 @@ class MQTT : private concurrency::OSThread
     virtual int32_t runOnce() override;
 
   private:
+    /// What runOnce() saw, see wasConnectedDirectly()
+    bool connectedDirectly = false;
+
     std::string cryptTopic = "/2/e/";   // msh/2/e/CHANNELID/NODEID
     std::string jsonTopic = "/2/json/"; // msh/2/json/CHANNELID/NODEID
     std::string mapTopic = "/2/map/";   // For protobuf-encoded MapReport messages
@@ -106,6 +149,9 @@ class MQTT : private concurrency::OSThread
     /// Called when a new publish arrives from the MQTT server
     void onReceive(char *topic, byte *payload, size_t length);
 
+    /// The body of runOnce(), called with clientLock held
+    int32_t pollClient();
+
     void publishQueuedMessages();
 
     void publishNodeInfo();
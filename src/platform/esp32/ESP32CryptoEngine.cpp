@@ -6,12 +6,29 @@
 class ESP32CryptoEngine : public CryptoEngine
 {
 
+    /// Context for a key installed directly with setKey()
     mbedtls_aes_context aes;
 
+    /// Pre-keyed contexts, one per key slot
+    mbedtls_aes_context slotAes[MAX_KEY_SLOTS];
+
+    /// The context encrypt() uses, either aes or one of slotAes
+    mbedtls_aes_context *active = &aes;
+
   public:
-    ESP32CryptoEngine() { mbedtls_aes_init(&aes); }
+    ESP32CryptoEngine()
+    {
+        mbedtls_aes_init(&aes);
+        for (int i = 0; i < MAX_KEY_SLOTS; i++)
+            mbedtls_aes_init(&slotAes[i]);
+    }
 
-    ~ESP32CryptoEngine() { mbedtls_aes_free(&aes); }
+    ~ESP32CryptoEngine()
+    {
+        mbedtls_aes_free(&aes);
+        for (int i = 0; i < MAX_KEY_SLOTS; i++)
+            mbedtls_aes_free(&slotAes[i]);
+    }
 
     /**
      * Set the key used for encrypt, decrypt.
@@ -25,6 +42,7 @@ class ESP32CryptoEngine : public CryptoEngine
     virtual void setKey(const CryptoKey &k) override
     {
         CryptoEngine::setKey(k);
+        active = &aes;
 
         if (key.length != 0) {
             auto res = mbedtls_aes_setkey_enc(&aes, key.bytes, key.length * 8);
@@ -32,6 +50,30 @@ class ESP32CryptoEngine : public CryptoEngine
         }
     }
 
+    virtual void setKeySlot(uint8_t slot, const CryptoKey &k) override
+    {
+        if (slot >= MAX_KEY_SLOTS)
+            return;
+        bool wasActive = (activeSlot == slot);
+        CryptoEngine::setKeySlot(slot, k);
+
+        if (k.length > 0) {
+            auto res = mbedtls_aes_setkey_enc(&slotAes[slot], k.bytes, k.length * 8);
+            assert(!res);
+        }
+        if (wasActive)
+            useKeySlot(slot);
+    }
+
+    virtual void useKeySlot(uint8_t slot) override
+    {
+        if (slot >= MAX_KEY_SLOTS)
+            return;
+        key = slotKeys[slot];
+        active = &slotAes[slot];
+        activeSlot = slot;
+    }
+
     /**
      * Encrypt a packet
      *
@@ -50,7 +92,7 @@ class ESP32CryptoEngine : public CryptoEngine
                 memset(scratch + numBytes, 0,
                        sizeof(scratch) - numBytes); // Fill rest of buffer with zero (in case cypher looks at it)
 
-                auto res = mbedtls_aes_crypt_ctr(&aes, numBytes, &nc_off, nonce, stream_block, scratch, bytes);
+                auto res = mbedtls_aes_crypt_ctr(active, numBytes, &nc_off, nonce, stream_block, scratch, bytes);
                 assert(!res);
             } else {
                 LOG_ERROR("Packet too large for crypto engine: %d. noop encryption!\n", numBytes);
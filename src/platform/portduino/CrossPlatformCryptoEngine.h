@@ -0,0 +1,111 @@
+#pragma once
+
+#include "AES.h"
+#include "CTR.h"
+#include "CryptoEngine.h"
+#include "configuration.h"
+
+/** A platform independent AES engine implemented using Tiny-AES
+ */
+class CrossPlatformCryptoEngine : public CryptoEngine
+{
+
+    /// The context encrypt() uses, either ownCtr or one of slotCtr
+    CTRCommon *ctr = NULL;
+
+    /// Context for a key installed directly with setKey()
+    CTRCommon *ownCtr = NULL;
+
+    /// Pre-keyed contexts, one per key slot
+    CTRCommon *slotCtr[MAX_KEY_SLOTS] = {};
+
+  public:
+    CrossPlatformCryptoEngine() {}
+
+    ~CrossPlatformCryptoEngine()
+    {
+        delete ownCtr;
+        for (int i = 0; i < MAX_KEY_SLOTS; i++)
+            delete slotCtr[i];
+    }
+
+    /**
+     * Set the key used for encrypt, decrypt.
+     *
+     * As a special case: If all bytes are zero, we assume _no encryption_ and send all data in cleartext.
+     *
+     * @param numBytes must be 16 (AES128), 32 (AES256) or 0 (no crypt)
+     * @param bytes a _static_ buffer that will remain valid for the life of this crypto instance (i.e. this class will cache the
+     * provided pointer)
+     */
+    virtual void setKey(const CryptoKey &k) override
+    {
+        CryptoEngine::setKey(k);
+        LOG_DEBUG("Installing AES%d key!\n", key.length * 8);
+        delete ownCtr;
+        ownCtr = ctr = makeCtr(key);
+    }
+
+    virtual void setKeySlot(uint8_t slot, const CryptoKey &k) override
+    {
+        if (slot >= MAX_KEY_SLOTS)
+            return;
+        bool wasActive = (activeSlot == slot);
+        CryptoEngine::setKeySlot(slot, k);
+        delete slotCtr[slot];
+        slotCtr[slot] = makeCtr(k);
+        if (wasActive)
+            useKeySlot(slot); // don't leave ctr pointing at the context we just freed
+    }
+
+    virtual void useKeySlot(uint8_t slot) override
+    {
+        if (slot >= MAX_KEY_SLOTS)
+            return;
+        key = slotKeys[slot];
+        ctr = slotCtr[slot];
+        activeSlot = slot;
+    }
+
+    /**
+     * Encrypt a packet
+     *
+     * @param bytes is updated in place
+     */
+    virtual void encrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes) override
+    {
+        if (key.length > 0) {
+            initNonce(fromNode, packetId);
+            if (numBytes <= MAX_BLOCKSIZE) {
+                // CTR only xors a keystream into the data, so it is safe to encrypt in place
+                ctr->setIV(nonce, sizeof(nonce));
+                ctr->setCounterSize(4);
+                ctr->encrypt(bytes, bytes, numBytes);
+            } else {
+                LOG_ERROR("Packet too large for crypto engine: %d. noop encryption!\n", numBytes);
+            }
+        }
+    }
+
+    virtual void decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes) override
+    {
+        // For CTR, the implementation is the same
+        encrypt(fromNode, packetId, numBytes, bytes);
+    }
+
+  private:
+    /// Allocate a CTR context and run the AES key expansion for k, or return NULL if k means "no encryption"
+    static CTRCommon *makeCtr(const CryptoKey &k)
+    {
+        if (k.length <= 0)
+            return NULL;
+
+        CTRCommon *c;
+        if (k.length == 16)
+            c = new CTR<AES128>();
+        else
+            c = new CTR<AES256>();
+        c->setKey(k.bytes, k.length);
+        return c;
+    }
+};
@@ -0,0 +1,288 @@
+#include "EpollServerAPI.h"
+#include "configuration.h"
+#include <algorithm>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LISTEN_ID 0
+
+SocketStream::~SocketStream()
+{
+    ::close(fd);
+}
+
+void SocketStream::fill()
+{
+    rxPos = rxLen = 0;
+    while (open) {
+        ssize_t n = recv(fd, rxBuf, sizeof(rxBuf), 0);
+        if (n > 0)
+            rxLen = n;
+        else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            open = false; // client went away
+        else if (errno == EINTR)
+            continue;
+        return;
+    }
+}
+
+int SocketStream::available()
+{
+    if (rxPos == rxLen)
+        fill();
+    return rxLen - rxPos;
+}
+
+int SocketStream::read()
+{
+    return available() ? rxBuf[rxPos++] : -1;
+}
+
+size_t SocketStream::read(uint8_t *buf, size_t len)
+{
+    size_t n = std::min(len, (size_t)available());
+    memcpy(buf, rxBuf + rxPos, n);
+    rxPos += n;
+    return n;
+}
+
+int SocketStream::peek()
+{
+    return available() ? rxBuf[rxPos] : -1;
+}
+
+size_t SocketStream::write(const uint8_t *buf, size_t len)
+{
+    if (!open)
+        return 0;
+    if (pendingTx() + len > EPOLL_API_TX_MAX) {
+        LOG_WARN("API client on fd %d isn't reading, dropping it\n", fd);
+        shutdown();
+        return 0;
+    }
+
+    txBuf.insert(txBuf.end(), buf, buf + len);
+    return len;
+}
+
+void SocketStream::flush()
+{
+    while (open && pendingTx()) {
+        ssize_t n = send(fd, txBuf.data() + txPos, pendingTx(), MSG_NOSIGNAL);
+        if (n > 0)
+            txPos += n;
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else {
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                open = false;
+            break; // socket is full, epoll will tell us when it has room
+        }
+    }
+
+    if (!open || txPos == txBuf.size()) {
+        txBuf.clear();
+        txPos = 0;
+    } else if (txPos > txBuf.size() / 2) {
+        txBuf.erase(txBuf.begin(), txBuf.begin() + txPos); // don't let the sent part grow forever
+        txPos = 0;
+    }
+}
+
+void SocketStream::shutdown()
+{
+    if (open) {
+        ::shutdown(fd, SHUT_RDWR);
+        open = false;
+    }
+}
+
+EpollServerAPI::EpollServerAPI(int fd, uint64_t id, EpollServerPort &port)
+    : StreamAPI(&sock), concurrency::OSThread("EpollServerAPI"), id(id), sock(fd), port(port)
+{
+}
+
+void EpollServerAPI::close()
+{
+    sock.shutdown(); // drop tcp connection
+    StreamAPI::close();
+}
+
+uint32_t EpollServerAPI::wantedEvents() const
+{
+    return EPOLLIN | EPOLLRDHUP | EPOLLONESHOT | (sock.pendingTx() ? (uint32_t)EPOLLOUT : 0);
+}
+
+int32_t EpollServerAPI::runOnce()
+{
+    if (sock.isOpen()) {
+        // Let a client that is behind drain what it already has before we take any more from PhoneAPI for it (its packets
+        // wait in PhoneAPI meanwhile), so one slow reader can't hold up the main loop or eat all our memory
+        canWrite = sock.pendingTx() < EPOLL_API_TX_HIGH_WATER;
+        runOncePart();
+        sock.flush(); // in case writeStream() didn't run
+    }
+
+    if (!sock.isOpen()) {
+        LOG_INFO("API client %u dropped connection\n", (uint32_t)id);
+        close();
+        finished = true;
+        enabled = false; // we no longer need to run
+        port.onFinished();
+        return 0;
+    }
+
+    port.rearm(this);
+    return EPOLL_API_IDLE_MSEC;
+}
+
+EpollServerPort *EpollServerPort::start(int port)
+{
+    int listenFd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        LOG_ERROR("Can't create API socket: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    int one = 1, zero = 0;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero)); // take IPv4 clients too
+
+    struct sockaddr_in6 addr = {};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, EPOLL_API_MAX_CLIENTS) != 0) {
+        LOG_ERROR("Can't listen on TCP port %d: %s\n", port, strerror(errno));
+        ::close(listenFd);
+        return NULL;
+    }
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.u64 = LISTEN_ID;
+    if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) != 0) {
+        LOG_ERROR("Can't set up epoll for the API server: %s\n", strerror(errno));
+        if (epollFd >= 0)
+            ::close(epollFd);
+        ::close(listenFd);
+        return NULL;
+    }
+
+    return new EpollServerPort(listenFd, epollFd);
+}
+
+EpollServerPort::EpollServerPort(int listenFd, int epollFd)
+    : concurrency::OSThread("ApiServer"), listenFd(listenFd), epollFd(epollFd), stopping(false)
+{
+    ioThread = std::thread(&EpollServerPort::ioLoop, this);
+}
+
+EpollServerPort::~EpollServerPort()
+{
+    stopping = true;
+    ioThread.join();
+
+    for (auto api : clients)
+        delete api;
+    ::close(epollFd);
+    ::close(listenFd);
+}
+
+void EpollServerPort::ioLoop()
+{
+    struct epoll_event events[EPOLL_API_MAX_CLIENTS + 1];
+    while (!stopping) {
+        int n = epoll_wait(epollFd, events, EPOLL_API_MAX_CLIENTS + 1, 100); // time out now and then to check stopping
+        if (n <= 0)
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(readyLock);
+            for (int i = 0; i < n; i++)
+                ready.push_back(events[i].data.u64);
+        }
+        wake(); // so the main loop calls runOnce(), which passes these on
+        concurrency::mainDelay.interrupt();
+    }
+}
+
+void EpollServerPort::rearm(EpollServerAPI *api)
+{
+    struct epoll_event ev = {};
+    ev.events = api->wantedEvents();
+    ev.data.u64 = api->id;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, api->getFd(), &ev) != 0)
+        LOG_ERROR("Can't rearm API client %u: %s\n", (uint32_t)api->id, strerror(errno));
+}
+
+void EpollServerPort::acceptClients()
+{
+    int fd;
+    while ((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        if (clients.size() >= EPOLL_API_MAX_CLIENTS) {
+            LOG_WARN("Already have %d API clients, refusing another\n", EPOLL_API_MAX_CLIENTS);
+            ::close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // StreamAPI already batches its writes
+
+        auto api = new EpollServerAPI(fd, nextId++, *this);
+        struct epoll_event ev = {};
+        ev.events = api->wantedEvents();
+        ev.data.u64 = api->id;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            LOG_ERROR("Can't watch API client: %s\n", strerror(errno));
+            delete api;
+            continue;
+        }
+        clients.push_back(api);
+        LOG_INFO("Incoming API connection %u, %u open\n", (uint32_t)api->id, (uint32_t)clients.size());
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+        LOG_WARN("API accept failed: %s\n", strerror(errno));
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.u64 = LISTEN_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, listenFd, &ev);
+}
+
+int32_t EpollServerPort::runOnce()
+{
+    std::vector<uint64_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(readyLock);
+        ids.swap(ready);
+    }
+
+    for (auto id : ids) {
+        if (id == LISTEN_ID) {
+            acceptClients();
+            continue;
+        }
+        auto it = std::find_if(clients.begin(), clients.end(), [id](EpollServerAPI *api) { return api->id == id; });
+        if (it != clients.end()) // else it has finished since the I/O thread saw it
+            (*it)->onSocketReady();
+    }
+
+    for (size_t i = 0; i < clients.size();) {
+        if (clients[i]->isFinished()) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, clients[i]->getFd(), NULL);
+            delete clients[i];
+            clients.erase(clients.begin() + i);
+        } else {
+            i++;
+        }
+    }
+
+    return INT32_MAX; // the I/O thread wakes us
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "StreamAPI.h"
+#include "concurrency/OSThread.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef EPOLL_API_MAX_CLIENTS
+#define EPOLL_API_MAX_CLIENTS 8
+#endif
+
+// A client with more than this much output waiting on it gets no further packets until it catches up
+#ifndef EPOLL_API_TX_HIGH_WATER
+#define EPOLL_API_TX_HIGH_WATER (64 * 1024)
+#endif
+
+// A client that somehow falls this far behind is dropped
+#ifndef EPOLL_API_TX_MAX
+#define EPOLL_API_TX_MAX (1024 * 1024)
+#endif
+
+// Sockets wake their session as soon as they are readable, this is just a backstop for anything that doesn't
+#ifndef EPOLL_API_IDLE_MSEC
+#define EPOLL_API_IDLE_MSEC 1000
+#endif
+
+/**
+ * A nonblocking TCP socket as a Stream.  Reads come out of what the last recv() returned, and writes are queued until flush(),
+ * which sends whatever the socket will take right now, so the main loop never waits on a client.
+ */
+class SocketStream : public Stream
+{
+  public:
+    explicit SocketStream(int fd) : fd(fd) {}
+
+    /// Closes the socket
+    ~SocketStream();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+
+    /// Take up to len bytes of what has arrived, without waiting for more
+    size_t read(uint8_t *buf, size_t len);
+
+    using Print::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t len) override;
+
+    /// Send as much of the queued output as the socket will take without blocking
+    void flush() override;
+
+    /// Stop talking to the client (the socket stays open until we are deleted)
+    void shutdown();
+
+    int getFd() const { return fd; }
+    bool isOpen() const { return open; }
+
+    /// Bytes queued by write() that the socket hasn't taken yet
+    size_t pendingTx() const { return txBuf.size() - txPos; }
+
+  private:
+    int fd;
+    bool open = true;
+
+    uint8_t rxBuf[MAX_STREAM_BUF_SIZE];
+    size_t rxPos = 0, rxLen = 0;
+
+    std::vector<uint8_t> txBuf;
+    size_t txPos = 0;
+
+    /// recv() whatever has arrived into rxBuf, which must be empty
+    void fill();
+};
+
+class EpollServerPort;
+
+/**
+ * One client of the TCP API.  Unlike ServerAPI it doesn't poll: EpollServerPort wakes it when its socket is readable (or
+ * writable again) and PhoneAPI wakes it when there are new packets for it.
+ */
+class EpollServerAPI : public StreamAPI, private concurrency::OSThread
+{
+  public:
+    const uint64_t id;
+
+    EpollServerAPI(int fd, uint64_t id, EpollServerPort &port);
+
+    /// override close to also shutdown the TCP link
+    virtual void close() override;
+
+    /// Called by EpollServerPort when our socket has something for us
+    void onSocketReady() { wake(); }
+
+    /// Once true our session is over and EpollServerPort should delete us
+    bool isFinished() const { return finished; }
+
+    int getFd() const { return sock.getFd(); }
+
+    /// What we need to hear about from epoll next
+    uint32_t wantedEvents() const;
+
+  protected:
+    /// Like ServerAPI, don't publish EVENT_SERIAL_CONNECTED/DISCONNECTED for network links
+    virtual void onConnectionChanged(bool connected) override {}
+
+    virtual void onNowHasData(uint32_t fromRadioNum) override { wake(); }
+
+    virtual int32_t runOnce() override;
+
+    virtual bool checkIsConnected() override { return sock.isOpen(); }
+
+    virtual size_t readAvailable(uint8_t *buf, size_t len) override { return sock.read(buf, len); }
+
+  private:
+    SocketStream sock;
+    EpollServerPort &port;
+    bool finished = false;
+};
+
+/**
+ * meshtasticd's TCP API server.  It accepts up to EPOLL_API_MAX_CLIENTS concurrent sessions (the python CLI, a dashboard, Home
+ * Assistant...), where APIServerPort only allows one and polls for it.
+ *
+ * An I/O thread sits in epoll_wait() and just passes on which sockets are ready, everything else (accepting, and the sessions
+ * themselves) happens on the main loop as before.  Every socket is registered EPOLLONESHOT, and rearmed once the main loop
+ * has dealt with it, so the I/O thread doesn't spin on a socket it is waiting for us to read.
+ */
+class EpollServerPort : private concurrency::OSThread
+{
+  public:
+    /// Start listening on port, returns NULL if that fails
+    static EpollServerPort *start(int port);
+
+    /// Stops the I/O thread and drops every client
+    ~EpollServerPort();
+
+    /// Called by a session once it has handled its socket, to hear about it again
+    void rearm(EpollServerAPI *api);
+
+    /// Called by a session that has finished, so we delete it
+    void onFinished() { wake(); }
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    int listenFd, epollFd;
+
+    std::vector<EpollServerAPI *> clients;
+    uint64_t nextId = 1; // 0 is the listening socket
+
+    /// ids of the sockets the I/O thread has seen become ready, that we haven't handled yet
+    std::mutex readyLock;
+    std::vector<uint64_t> ready;
+
+    std::atomic<bool> stopping;
+    std::thread ioThread;
+
+    EpollServerPort(int listenFd, int epollFd);
+
+    void ioLoop();
+
+    /// Accept every pending connection
+    void acceptClients();
+};
@@ -0,0 +1,228 @@
+#include "HardwareCryptoEngine.h"
+#include "configuration.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HW_AES_X86 1
+#include <wmmintrin.h>
+#define HW_AES_TARGET __attribute__((target("aes,sse2")))
+#elif defined(__aarch64__)
+#define HW_AES_ARM 1
+#include <arm_neon.h>
+#ifdef __linux__
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#ifdef __clang__
+#define HW_AES_TARGET __attribute__((target("aes")))
+#else
+#define HW_AES_TARGET __attribute__((target("+crypto")))
+#endif
+#endif
+
+static const uint8_t sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, 0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59,
+    0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, 0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1,
+    0x71, 0xd8, 0x31, 0x15, 0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, 0x09, 0x83,
+    0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, 0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b,
+    0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf, 0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c,
+    0x9f, 0xa8, 0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, 0xcd, 0x0c, 0x13, 0xec,
+    0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, 0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee,
+    0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, 0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08, 0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6,
+    0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, 0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9,
+    0x86, 0xc1, 0x1d, 0x9e, 0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, 0x8c, 0xa1,
+    0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+
+/**
+ * FIPS-197 key expansion.  This only runs when a key is installed, so a portable byte-wise version is plenty fast.
+ */
+static void expandKey(HardwareCryptoEngine::KeySchedule &ks, const CryptoKey &k)
+{
+    const int nk = (k.length == 16) ? 4 : 8; // key words, anything but AES128 is treated as AES256 like the other engines
+    ks.rounds = nk + 6;
+    const int totalWords = 4 * (ks.rounds + 1);
+
+    uint8_t *w = &ks.roundKeys[0][0];
+    memcpy(w, k.bytes, nk * 4);
+
+    uint8_t rcon = 0x01;
+    for (int i = nk; i < totalWords; i++) {
+        uint8_t t[4];
+        memcpy(t, w + (i - 1) * 4, 4);
+        if (i % nk == 0) {
+            uint8_t t0 = t[0];
+            t[0] = sbox[t[1]] ^ rcon;
+            t[1] = sbox[t[2]];
+            t[2] = sbox[t[3]];
+            t[3] = sbox[t0];
+            rcon = (rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0);
+        } else if (nk > 6 && i % nk == 4) {
+            for (int j = 0; j < 4; j++)
+                t[j] = sbox[t[j]];
+        }
+        for (int j = 0; j < 4; j++)
+            w[i * 4 + j] = w[(i - nk) * 4 + j] ^ t[j];
+    }
+}
+
+/// Add one to the 32 bit big endian block counter in the last four bytes of the nonce
+static inline void incrementCounter(uint8_t *counter)
+{
+    for (int i = 15; i >= 12; i--)
+        if (++counter[i] != 0)
+            break;
+}
+
+#if defined(HW_AES_X86) || defined(HW_AES_ARM)
+
+/**
+ * XOR the AES-CTR keystream for counter into numBytes of bytes, in place
+ */
+HW_AES_TARGET static void ctrXor(const HardwareCryptoEngine::KeySchedule &ks, uint8_t *counter, uint8_t *bytes, size_t numBytes)
+{
+#ifdef HW_AES_X86
+    __m128i rk[15];
+    for (int r = 0; r <= ks.rounds; r++)
+        rk[r] = _mm_loadu_si128((const __m128i *)ks.roundKeys[r]);
+
+    while (numBytes > 0) {
+        __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)counter), rk[0]);
+        for (int r = 1; r < ks.rounds; r++)
+            s = _mm_aesenc_si128(s, rk[r]);
+        s = _mm_aesenclast_si128(s, rk[ks.rounds]);
+        incrementCounter(counter);
+
+        if (numBytes >= 16) {
+            _mm_storeu_si128((__m128i *)bytes, _mm_xor_si128(s, _mm_loadu_si128((const __m128i *)bytes)));
+            bytes += 16;
+            numBytes -= 16;
+        } else {
+            uint8_t stream[16];
+            _mm_storeu_si128((__m128i *)stream, s);
+            for (size_t i = 0; i < numBytes; i++)
+                bytes[i] ^= stream[i];
+            numBytes = 0;
+        }
+    }
+#else
+    uint8x16_t rk[15];
+    for (int r = 0; r <= ks.rounds; r++)
+        rk[r] = vld1q_u8(ks.roundKeys[r]);
+
+    while (numBytes > 0) {
+        uint8x16_t s = vld1q_u8(counter);
+        for (int r = 0; r < ks.rounds - 1; r++)
+            s = vaesmcq_u8(vaeseq_u8(s, rk[r]));
+        s = veorq_u8(vaeseq_u8(s, rk[ks.rounds - 1]), rk[ks.rounds]);
+        incrementCounter(counter);
+
+        if (numBytes >= 16) {
+            vst1q_u8(bytes, veorq_u8(s, vld1q_u8(bytes)));
+            bytes += 16;
+            numBytes -= 16;
+        } else {
+            uint8_t stream[16];
+            vst1q_u8(stream, s);
+            for (size_t i = 0; i < numBytes; i++)
+                bytes[i] ^= stream[i];
+            numBytes = 0;
+        }
+    }
+#endif
+}
+
+/// Encrypt one FIPS-197 test vector (appendix C) by running CTR over a zero block, with the plaintext as the counter
+static bool knownAnswerOk(const CryptoKey &k, const uint8_t *expected)
+{
+    static const uint8_t plain[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                      0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+    HardwareCryptoEngine::KeySchedule ks;
+    expandKey(ks, k);
+
+    uint8_t counter[16], block[16] = {0};
+    memcpy(counter, plain, sizeof(counter));
+    ctrXor(ks, counter, block, sizeof(block));
+    return memcmp(block, expected, sizeof(block)) == 0;
+}
+
+#endif
+
+bool HardwareCryptoEngine::isSupported()
+{
+#if defined(HW_AES_X86)
+    __builtin_cpu_init(); // we may be called from a static initializer, before the runtime has probed the CPU
+    if (!__builtin_cpu_supports("aes"))
+        return false;
+#elif defined(HW_AES_ARM) && defined(__linux__)
+    if (!(getauxval(AT_HWCAP) & HWCAP_AES))
+        return false;
+#else
+    return false;
+#endif
+
+#if defined(HW_AES_X86) || defined(HW_AES_ARM)
+    static const uint8_t expected128[16] = {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+                                            0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+    static const uint8_t expected256[16] = {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+                                            0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89};
+    CryptoKey k;
+    for (int i = 0; i < 32; i++)
+        k.bytes[i] = i;
+
+    k.length = 16;
+    if (!knownAnswerOk(k, expected128))
+        return false;
+    k.length = 32;
+    return knownAnswerOk(k, expected256);
+#endif
+}
+
+void HardwareCryptoEngine::setKey(const CryptoKey &k)
+{
+    CryptoEngine::setKey(k);
+    LOG_DEBUG("Installing hardware AES%d key!\n", key.length * 8);
+    if (key.length > 0)
+        expandKey(own, key);
+    active = &own;
+}
+
+void HardwareCryptoEngine::setKeySlot(uint8_t slot, const CryptoKey &k)
+{
+    if (slot >= MAX_KEY_SLOTS)
+        return;
+    bool wasActive = (activeSlot == slot);
+    CryptoEngine::setKeySlot(slot, k);
+    if (k.length > 0)
+        expandKey(slots[slot], k);
+    if (wasActive)
+        useKeySlot(slot);
+}
+
+void HardwareCryptoEngine::useKeySlot(uint8_t slot)
+{
+    if (slot >= MAX_KEY_SLOTS)
+        return;
+    key = slotKeys[slot];
+    active = &slots[slot];
+    activeSlot = slot;
+}
+
+void HardwareCryptoEngine::encrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes)
+{
+    if (key.length > 0) {
+        initNonce(fromNode, packetId);
+        if (numBytes <= MAX_BLOCKSIZE) {
+#if defined(HW_AES_X86) || defined(HW_AES_ARM)
+            ctrXor(*active, nonce, bytes, numBytes);
+#endif
+        } else {
+            LOG_ERROR("Packet too large for crypto engine: %d. noop encryption!\n", numBytes);
+        }
+    }
+}
+
+void HardwareCryptoEngine::decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes)
+{
+    // For CTR, the implementation is the same
+    encrypt(fromNode, packetId, numBytes, bytes);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CryptoEngine.h"
+
+/** An AES-CTR engine using the host CPU's AES instructions (AES-NI on x86-64, the ARMv8 crypto extensions on aarch64).
+ *
+ * Only construct this if isSupported() returned true, otherwise use CrossPlatformCryptoEngine.  Packets are encrypted in
+ * place, one keystream block at a time, so no scratch buffer is needed.
+ */
+class HardwareCryptoEngine : public CryptoEngine
+{
+  public:
+    /// Expanded AES round keys, in the byte order used by both AES-NI and ARMv8
+    struct KeySchedule {
+        uint8_t roundKeys[15][16];
+        uint8_t rounds; // 10 for AES128, 14 for AES256
+    };
+
+  private:
+    /// Schedule for a key installed directly with setKey()
+    KeySchedule own = {};
+
+    /// Pre-expanded schedules, one per key slot
+    KeySchedule slots[MAX_KEY_SLOTS] = {};
+
+    /// The schedule encrypt() uses, either own or one of slots
+    const KeySchedule *active = &own;
+
+  public:
+    HardwareCryptoEngine() {}
+
+    /**
+     * Return true if this CPU has AES instructions and they pass a known answer test
+     */
+    static bool isSupported();
+
+    virtual void setKey(const CryptoKey &k) override;
+    virtual void setKeySlot(uint8_t slot, const CryptoKey &k) override;
+    virtual void useKeySlot(uint8_t slot) override;
+
+    /**
+     * Encrypt a packet
+     *
+     * @param bytes is updated in place
+     */
+    virtual void encrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes) override;
+    virtual void decrypt(uint32_t fromNode, uint64_t packetId, size_t numBytes, uint8_t *bytes) override;
+};
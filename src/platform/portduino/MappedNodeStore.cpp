@@ -0,0 +1,79 @@
+#include "MappedNodeStore.h"
+#include "configuration.h"
+#include "mesh/mesh-pb-constants.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NODE_STORE_MAGIC 0x4e444253 // "NDBS"
+
+MappedNodeStore *mappedNodeStore;
+
+MappedNodeStore *MappedNodeStore::open(const char *path, uint32_t capacity)
+{
+    if (capacity > NODEDB_MAX_SLOTS) {
+        LOG_WARN("Node store %s can't be bigger than %u nodes, NodeDB couldn't index the rest\n", path, NODEDB_MAX_SLOTS);
+        capacity = NODEDB_MAX_SLOTS;
+    }
+
+    int fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Can't open node store %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    Header old = {};
+    bool valid = fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header) && pread(fd, &old, sizeof(old), 0) == sizeof(old) &&
+                 old.magic == NODE_STORE_MAGIC && old.recordSize == sizeof(meshtastic_NodeInfoLite);
+    if (!valid && st.st_size > 0) {
+        LOG_WARN("Node store %s was written by a different build, starting it over\n", path);
+        if (ftruncate(fd, 0) != 0) // so what we grow it back to is all zeros
+            LOG_ERROR("Can't truncate node store %s: %s\n", path, strerror(errno));
+    }
+
+    size_t len = sizeof(Header) + (size_t)capacity * sizeof(meshtastic_NodeInfoLite);
+    if (ftruncate(fd, len) != 0) {
+        LOG_ERROR("Can't size node store %s for %u nodes: %s\n", path, capacity, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Can't map node store %s: %s\n", path, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+
+    Header *header = (Header *)map;
+    if (!valid) {
+        header->magic = NODE_STORE_MAGIC;
+        header->recordSize = sizeof(meshtastic_NodeInfoLite);
+        header->count = 0;
+    } else if (header->count > capacity) {
+        LOG_WARN("Node store %s held %u nodes, but MaxNodes is %u, dropping the rest\n", path, header->count, capacity);
+        header->count = capacity;
+    }
+    header->capacity = capacity;
+
+    LOG_INFO("Mapped node store %s, %u of %u records in use\n", path, header->count, capacity);
+    return new MappedNodeStore(fd, len, header);
+}
+
+MappedNodeStore::~MappedNodeStore()
+{
+    msync(header, mapLen, MS_SYNC);
+    munmap(header, mapLen);
+    close(fd);
+}
+
+void MappedNodeStore::sync(uint32_t count, bool wait)
+{
+    header->count = count;
+    if (msync(header, mapLen, wait ? MS_SYNC : MS_ASYNC) != 0)
+        LOG_ERROR("Can't sync node store: %s\n", strerror(errno));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "mesh/generated/meshtastic/deviceonly.pb.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Opt-in (General.NodeStore in config.yaml) home for NodeDB's NodeInfoLite records on meshtasticd: a file of fixed size
+ * records that we mmap.  The node DB is usable as soon as the file is mapped, with nothing to decode, and saving it is an
+ * msync() of whatever pages changed instead of re-encoding every node into db.proto.
+ *
+ * The records are stored raw, so a file is only good for builds with the same NodeInfoLite layout.  One with a different
+ * record size is started over.
+ */
+class MappedNodeStore
+{
+  public:
+    /// Map path (creating or resizing it as needed) to hold capacity records, returns NULL if that fails
+    static MappedNodeStore *open(const char *path, uint32_t capacity);
+
+    /// Flushes everything to disk and unmaps the file
+    ~MappedNodeStore();
+
+    meshtastic_NodeInfoLite *records() { return (meshtastic_NodeInfoLite *)(header + 1); }
+
+    uint32_t capacity() const { return header->capacity; }
+
+    /// How many records (from the start) were in use as of the last sync()
+    uint32_t getCount() const { return header->count; }
+
+    /**
+     * Note how many records are in use and start writing back the pages that changed.
+     * @param wait if true, block until they are on disk
+     */
+    void sync(uint32_t count, bool wait = false);
+
+  private:
+    struct Header {
+        uint32_t magic;
+        uint32_t recordSize; // sizeof(meshtastic_NodeInfoLite) of the build that wrote the file
+        uint32_t capacity;
+        uint32_t count;
+    };
+
+    int fd;
+    size_t mapLen;
+    Header *header; // the start of the mapping, the records follow it
+
+    MappedNodeStore(int fd, size_t mapLen, Header *header) : fd(fd), mapLen(mapLen), header(header) {}
+};
+
+/// Only non NULL when General.NodeStore is set
+extern MappedNodeStore *mappedNodeStore;
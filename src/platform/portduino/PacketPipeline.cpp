@@ -0,0 +1,149 @@
+#include "PacketPipeline.h"
+#include "Router.h"
+#include "configuration.h"
+#include "main.h"
+#if !MESHTASTIC_EXCLUDE_MQTT
+#include "mqtt/MQTT.h"
+#endif
+
+PacketPipeline *packetPipeline;
+
+PacketPipeline::PacketPipeline() : stopping(false)
+{
+    decodeThread = std::thread(&PacketPipeline::decodeLoop, this);
+    egressThread = std::thread(&PacketPipeline::egressLoop, this);
+    LOG_INFO("Packet pipeline started, decode and MQTT egress run on their own threads\n");
+}
+
+PacketPipeline::~PacketPipeline()
+{
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+    }
+    decodeWake.notify_all();
+    egressWake.notify_all();
+    decodeThread.join();
+    egressThread.join();
+
+    meshtastic_MeshPacket *p;
+    while (decodeIn.pop(p))
+        packetPool.release(p);
+    RxItem rx;
+    while (decodeOut.pop(rx)) {
+        packetPool.release(rx.p);
+        packetPool.release(rx.encrypted);
+    }
+#if !MESHTASTIC_EXCLUDE_MQTT
+    MQTTUplink *uplink;
+    while (egressIn.pop(uplink)) {
+        packetPool.release((meshtastic_MeshPacket *)uplink->packet);
+        delete uplink;
+    }
+#endif
+}
+
+bool PacketPipeline::submitForDecode(meshtastic_MeshPacket *p)
+{
+    if (!decodeIn.push(p))
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(wakeLock); // so the notify can't slip in between the worker's check and its wait
+    }
+    decodeWake.notify_one();
+    return true;
+}
+
+bool PacketPipeline::takeDecoded(RxItem &item)
+{
+    bool wasFull = decodeOut.isFull();
+    if (!decodeOut.pop(item))
+        return false;
+
+    if (wasFull) { // the decode thread may be waiting for room
+        {
+            std::lock_guard<std::mutex> lock(wakeLock);
+        }
+        decodeWake.notify_one();
+    }
+    return true;
+}
+
+bool PacketPipeline::submitForEgress(const meshtastic_MeshPacket *encrypted, const meshtastic_MeshPacket *decoded,
+                                     ChannelIndex chIndex)
+{
+#if !MESHTASTIC_EXCLUDE_MQTT
+    MQTTUplink uplink;
+    if (!mqtt->prepareSend(*encrypted, *decoded, chIndex, uplink))
+        return true;
+
+    if (moduleConfig.mqtt.proxy_to_client_enabled || !mqtt->wasConnectedDirectly()) {
+        if (mqtt->canPublishNow())
+            mqtt->addJson(*decoded, uplink); // a queued packet gets its JSON when the queue drains
+        mqtt->finishSend(uplink, true);      // the client proxy and the offline queue are main loop state
+        return true;
+    }
+
+    if (egressIn.isFull()) {
+        LOG_WARN("MQTT egress queue is full, not publishing packet 0x%x\n", decoded->id);
+        return false;
+    }
+
+    mqtt->addJson(*decoded, uplink);
+
+    MQTTUplink *queued = new MQTTUplink(std::move(uplink));
+    queued->packet = packetPool.share(queued->packet);
+    egressIn.push(queued); // we are the only producer, so there is still room
+
+    {
+        std::lock_guard<std::mutex> lock(wakeLock);
+    }
+    egressWake.notify_one();
+#endif
+    return true;
+}
+
+void PacketPipeline::decodeLoop()
+{
+    while (!stopping) {
+        meshtastic_MeshPacket *p;
+        // Don't take work we have nowhere to put, the main loop will catch up
+        if (decodeOut.isFull() || !decodeIn.pop(p)) {
+            std::unique_lock<std::mutex> lock(wakeLock);
+            decodeWake.wait_for(lock, std::chrono::milliseconds(100),
+                                [this] { return stopping || (!decodeIn.isEmpty() && !decodeOut.isFull()); });
+            continue;
+        }
+
+        RxItem item;
+        item.p = p;
+        item.encrypted = packetPool.allocCopy(*p); // keep the ciphertext for MQTT and rebroadcast
+        item.decoded = decryptAndDecode(p);
+        decodeOut.push(item); // checked for room above, and we are the only producer
+
+        router->wake(); // so the main loop calls Router::runOnce(), which drains decodeOut
+        concurrency::mainDelay.interrupt();
+    }
+}
+
+void PacketPipeline::egressLoop()
+{
+    while (!stopping) {
+        MQTTUplink *uplink;
+        if (!egressIn.pop(uplink)) {
+            std::unique_lock<std::mutex> lock(wakeLock);
+            egressWake.wait_for(lock, std::chrono::milliseconds(100), [this] { return stopping || !egressIn.isEmpty(); });
+            continue;
+        }
+
+#if !MESHTASTIC_EXCLUDE_MQTT
+        if (mqtt) {
+            concurrency::LockGuard guard(&mqtt->clientLock);
+            mqtt->finishSend(*uplink, false);
+        }
+        packetPool.release((meshtastic_MeshPacket *)uplink->packet);
+        delete uplink;
+#endif
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Channels.h"
+#include "MeshTypes.h"
+#include "concurrency/SPSCQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifndef PIPELINE_QUEUE_LEN
+#define PIPELINE_QUEUE_LEN 32
+#endif
+
+struct MQTTUplink;
+
+/**
+ * Opt-in (General.PipelineMode in config.yaml) multi-threaded receive pipeline for meshtasticd.
+ *
+ * Radio ingest, duplicate filtering and module dispatch stay on the main cooperative loop, because they share state
+ * (PacketHistory, pending retransmissions, NodeDB, the modules) with everything else.  The expensive decrypt/decode step
+ * and the network bound MQTT publish each get their own OS thread, connected to the main loop by bounded SPSC queues:
+ *
+ *   main loop (ingest + dedup) -> decode thread -> main loop (module dispatch) -> egress thread (MQTT)
+ *
+ * The egress thread only does the network part of a publish: MQTT::prepareSend() captures the channel id, gateway id and
+ * JSON on the main loop first, and publishes through the phone's client proxy or into the offline queue stay there too.
+ *
+ * fromRadioQueue and the toPhone ring are untouched, so everything the phone sees is unchanged.
+ */
+class PacketPipeline
+{
+  public:
+    /// A received packet on its way back from the decode thread
+    struct RxItem {
+        meshtastic_MeshPacket *p;         // decoded in place (if decoded is true)
+        meshtastic_MeshPacket *encrypted; // a copy of p as it came off the air
+        bool decoded;
+    };
+
+    PacketPipeline();
+
+    /// Stops and joins the worker threads, any packets still queued are released
+    ~PacketPipeline();
+
+    /**
+     * Called by the main loop.  Hand a received packet (already filtered for duplicates) to the decode thread, which takes
+     * ownership of it.  Returns false if that stage is backed up, in which case the caller still owns p.
+     */
+    bool submitForDecode(meshtastic_MeshPacket *p);
+
+    /// Called by the main loop, fetch the next packet the decode thread has finished with
+    bool takeDecoded(RxItem &item);
+
+    /**
+     * Called by the main loop instead of MQTT::onSend().  A direct publish to the server is queued for the egress thread, which
+     * keeps a shared reference to the packet so the caller may release its own, anything else is done right here.  Returns
+     * false (and drops the publish) if the egress stage is backed up.
+     */
+    bool submitForEgress(const meshtastic_MeshPacket *encrypted, const meshtastic_MeshPacket *decoded, ChannelIndex chIndex);
+
+  private:
+    concurrency::SPSCQueue<meshtastic_MeshPacket *, PIPELINE_QUEUE_LEN> decodeIn;
+    concurrency::SPSCQueue<RxItem, PIPELINE_QUEUE_LEN> decodeOut;
+    concurrency::SPSCQueue<MQTTUplink *, PIPELINE_QUEUE_LEN> egressIn;
+
+    std::mutex wakeLock;
+    std::condition_variable decodeWake, egressWake;
+    std::atomic<bool> stopping;
+
+    std::thread decodeThread, egressThread;
+
+    void decodeLoop();
+    void egressLoop();
+};
+
+/// Only non NULL when pipeline mode is enabled
+extern PacketPipeline *packetPipeline;
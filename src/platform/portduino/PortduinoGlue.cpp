@@ -1,6 +1,8 @@
 #include "CryptoEngine.h"
+#include "NodeDB.h"
 #include "PortduinoGPIO.h"
 #include "SPIChip.h"
+#include "concurrency/OSThread.h"
 #include "mesh/RF95Interface.h"
 #include "sleep.h"
 #include "target_specific.h"
@@ -13,6 +15,7 @@
 #include "yaml-cpp/yaml.h"
 #include <iostream>
 #include <map>
+#include <signal.h>
 #include <unistd.h>
 
 std::map<configNames, int> settingsMap;
@@ -35,6 +38,32 @@ void updateBatteryLevel(uint8_t level) NOT_IMPLEMENTED("updateBatteryLevel");
 
 int TCPPort = 4403;
 
+/// Set by SIGUSR1, picked up by portduinoCheckSignals() on the main loop where it is safe to log
+static volatile sig_atomic_t threadStatsRequested;
+
+static void onSigUsr1(int)
+{
+    threadStatsRequested = 1;
+}
+
+/// Set by SIGINT/SIGTERM, so the main loop can save what NodeDB is holding on to before we go
+static volatile sig_atomic_t exitRequested;
+
+static void onExitSignal(int sig)
+{
+    exitRequested = sig;
+    signal(sig, SIG_DFL); // if the main loop is stuck, a second one still kills us
+}
+
+void portduinoFlushBeforeExit()
+{
+    static bool flushed;
+    if (flushed || !nodeDB)
+        return;
+    flushed = true; // once only, a failed save can itself end up in recordCriticalError()
+    nodeDB->flushPendingSaves();
+}
+
 static error_t parse_opt(int key, char *arg, struct argp_state *state)
 {
     switch (key) {
@@ -280,6 +309,14 @@ void portduinoSetup()
         }
 
         settingsMap[maxnodes] = (yamlConfig["General"]["MaxNodes"]).as<int>(200);
+        if (settingsMap[maxnodes] > NODEDB_MAX_SLOTS) {
+            std::cout << "MaxNodes " << settingsMap[maxnodes] << " is more than NodeDB can hold, using " << NODEDB_MAX_SLOTS
+                      << std::endl;
+            settingsMap[maxnodes] = NODEDB_MAX_SLOTS;
+        }
+        settingsMap[maxpackethistory] = (yamlConfig["General"]["MaxPacketHistory"]).as<int>(0);
+        settingsMap[pipelinemode] = (yamlConfig["General"]["PipelineMode"]).as<bool>(false);
+        settingsStrings[nodestore] = (yamlConfig["General"]["NodeStore"]).as<std::string>("");
 
     } catch (YAML::Exception &e) {
         std::cout << "*** Exception " << e.what() << std::endl;
@@ -358,9 +395,27 @@ void portduinoSetup()
             exit(EXIT_FAILURE);
         }
     }
+
+    signal(SIGUSR1, onSigUsr1); // `kill -USR1 <pid>` dumps per thread runtime stats to the log
+    signal(SIGINT, onExitSignal);
+    signal(SIGTERM, onExitSignal);
+    atexit(portduinoFlushBeforeExit); // for any exit() that doesn't do it first
     return;
 }
 
+void portduinoCheckSignals()
+{
+    if (threadStatsRequested) {
+        threadStatsRequested = 0;
+        concurrency::OSThread::logAllStats();
+    }
+    if (exitRequested) {
+        LOG_INFO("Got signal %d, saving and exiting\n", (int)exitRequested);
+        portduinoFlushBeforeExit();
+        exit(EXIT_SUCCESS);
+    }
+}
+
 int initGPIOPin(int pinNum, const std::string gpioChipName)
 {
 #ifdef PORTDUINO_LINUX_HARDWARE
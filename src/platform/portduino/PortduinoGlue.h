@@ -51,7 +51,10 @@ enum configNames {
     webserver,
     webserverport,
     webserverrootpath,
-    maxnodes
+    maxnodes,
+    maxpackethistory,
+    pipelinemode,
+    nodestore
 };
 enum { no_screen, x11, st7789, st7735, st7735s, st7796, ili9341, ili9488, hx8357d };
 enum { no_touchscreen, xpt2046, stmpe610, gt911, ft5x06 };
@@ -60,4 +63,10 @@ enum { level_error, level_warn, level_info, level_debug, level_trace };
 extern std::map<configNames, int> settingsMap;
 extern std::map<configNames, std::string> settingsStrings;
 extern std::ofstream traceFile;
-int initGPIOPin(int pinNum, std::string gpioChipname);
\ No newline at end of file
+int initGPIOPin(int pinNum, std::string gpioChipname);
+
+/// Called from the main loop, handles anything our signal handlers asked for
+void portduinoCheckSignals();
+
+/// Write out the config saves NodeDB is still delaying, call before exit()
+void portduinoFlushBeforeExit();
\ No newline at end of file
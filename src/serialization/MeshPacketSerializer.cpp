@@ -1,6 +1,7 @@
 #include "MeshPacketSerializer.h"
 #include "JSON.h"
 #include "NodeDB.h"
+#include "PayloadCache.h"
 #include "mesh/generated/meshtastic/mqtt.pb.h"
 #include "mesh/generated/meshtastic/telemetry.pb.h"
 #include "modules/RoutingModule.h"
@@ -52,10 +53,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
         case meshtastic_PortNum_TELEMETRY_APP: {
             msgType = "telemetry";
             meshtastic_Telemetry scratch;
-            meshtastic_Telemetry *decoded = NULL;
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Telemetry_msg, &scratch)) {
-                decoded = &scratch;
+            const meshtastic_Telemetry *decoded = PayloadCache::get(*mp, &meshtastic_Telemetry_msg, scratch);
+            if (decoded) {
                 if (decoded->which_variant == meshtastic_Telemetry_device_metrics_tag) {
                     msgPayload["battery_level"] = new JSONValue((unsigned int)decoded->variant.device_metrics.battery_level);
                     msgPayload["voltage"] = new JSONValue(decoded->variant.device_metrics.voltage);
@@ -93,10 +92,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
         case meshtastic_PortNum_NODEINFO_APP: {
             msgType = "nodeinfo";
             meshtastic_User scratch;
-            meshtastic_User *decoded = NULL;
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_User_msg, &scratch)) {
-                decoded = &scratch;
+            const meshtastic_User *decoded = PayloadCache::get(*mp, &meshtastic_User_msg, scratch);
+            if (decoded) {
                 msgPayload["id"] = new JSONValue(decoded->id);
                 msgPayload["longname"] = new JSONValue(decoded->long_name);
                 msgPayload["shortname"] = new JSONValue(decoded->short_name);
@@ -111,10 +108,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
         case meshtastic_PortNum_POSITION_APP: {
             msgType = "position";
             meshtastic_Position scratch;
-            meshtastic_Position *decoded = NULL;
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Position_msg, &scratch)) {
-                decoded = &scratch;
+            const meshtastic_Position *decoded = PayloadCache::get(*mp, &meshtastic_Position_msg, scratch);
+            if (decoded) {
                 if ((int)decoded->time) {
                     msgPayload["time"] = new JSONValue((unsigned int)decoded->time);
                 }
@@ -156,10 +151,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
         case meshtastic_PortNum_WAYPOINT_APP: {
             msgType = "position";
             meshtastic_Waypoint scratch;
-            meshtastic_Waypoint *decoded = NULL;
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Waypoint_msg, &scratch)) {
-                decoded = &scratch;
+            const meshtastic_Waypoint *decoded = PayloadCache::get(*mp, &meshtastic_Waypoint_msg, scratch);
+            if (decoded) {
                 msgPayload["id"] = new JSONValue((unsigned int)decoded->id);
                 msgPayload["name"] = new JSONValue(decoded->name);
                 msgPayload["description"] = new JSONValue(decoded->description);
@@ -176,11 +169,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
         case meshtastic_PortNum_NEIGHBORINFO_APP: {
             msgType = "neighborinfo";
             meshtastic_NeighborInfo scratch;
-            meshtastic_NeighborInfo *decoded = NULL;
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_NeighborInfo_msg,
-                                     &scratch)) {
-                decoded = &scratch;
+            const meshtastic_NeighborInfo *decoded = PayloadCache::get(*mp, &meshtastic_NeighborInfo_msg, scratch);
+            if (decoded) {
                 msgPayload["node_id"] = new JSONValue((unsigned int)decoded->node_id);
                 msgPayload["node_broadcast_interval_secs"] = new JSONValue((unsigned int)decoded->node_broadcast_interval_secs);
                 msgPayload["last_sent_by_id"] = new JSONValue((unsigned int)decoded->last_sent_by_id);
@@ -203,16 +193,13 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
             if (mp->decoded.request_id) { // Only report the traceroute response
                 msgType = "traceroute";
                 meshtastic_RouteDiscovery scratch;
-                meshtastic_RouteDiscovery *decoded = NULL;
-                memset(&scratch, 0, sizeof(scratch));
-                if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_RouteDiscovery_msg,
-                                         &scratch)) {
-                    decoded = &scratch;
+                const meshtastic_RouteDiscovery *decoded = PayloadCache::get(*mp, &meshtastic_RouteDiscovery_msg, scratch);
+                if (decoded) {
                     JSONArray route; // Route this message took
                     // Lambda function for adding a long name to the route
                     auto addToRoute = [](JSONArray *route, NodeNum num) {
                         char long_name[40] = "Unknown";
-                        meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(num);
+                        const meshtastic_NodeInfoLite *node = nodeDB->getMeshNode(num);
                         bool name_known = node ? node->has_user : false;
                         if (name_known)
                             memcpy(long_name, node->user.long_name, sizeof(long_name));
@@ -245,10 +232,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
         case meshtastic_PortNum_PAXCOUNTER_APP: {
             msgType = "paxcounter";
             meshtastic_Paxcount scratch;
-            meshtastic_Paxcount *decoded = NULL;
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_Paxcount_msg, &scratch)) {
-                decoded = &scratch;
+            const meshtastic_Paxcount *decoded = PayloadCache::get(*mp, &meshtastic_Paxcount_msg, scratch);
+            if (decoded) {
                 msgPayload["wifi_count"] = new JSONValue((unsigned int)decoded->wifi);
                 msgPayload["ble_count"] = new JSONValue((unsigned int)decoded->ble);
                 msgPayload["uptime"] = new JSONValue((unsigned int)decoded->uptime);
@@ -261,11 +246,8 @@ std::string MeshPacketSerializer::JsonSerialize(const meshtastic_MeshPacket *mp,
 #endif
         case meshtastic_PortNum_REMOTE_HARDWARE_APP: {
             meshtastic_HardwareMessage scratch;
-            meshtastic_HardwareMessage *decoded = NULL;
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(mp->decoded.payload.bytes, mp->decoded.payload.size, &meshtastic_HardwareMessage_msg,
-                                     &scratch)) {
-                decoded = &scratch;
+            const meshtastic_HardwareMessage *decoded = PayloadCache::get(*mp, &meshtastic_HardwareMessage_msg, scratch);
+            if (decoded) {
                 if (decoded->type == meshtastic_HardwareMessage_Type_GPIOS_CHANGED) {
                     msgType = "gpios_changed";
                     msgPayload["gpio_value"] = new JSONValue((unsigned int)decoded->gpio_value);
@@ -1,3 +1,4 @@
+#include "NodeDB.h"
 #include "buzz.h"
 #include "configuration.h"
 #include "graphics/Screen.h"
@@ -13,6 +14,7 @@ void powerCommandsCheck()
 {
     if (rebootAtMsec && millis() > rebootAtMsec) {
         LOG_INFO("Rebooting\n");
+        nodeDB->flushPendingSaves();
 #if defined(ARCH_ESP32)
         ESP.restart();
 #elif defined(ARCH_NRF52)
@@ -44,6 +46,7 @@ void powerCommandsCheck()
 
     if (shutdownAtMsec && millis() > shutdownAtMsec) {
         LOG_INFO("Shutting down from admin command\n");
+        nodeDB->flushPendingSaves();
 #if defined(ARCH_NRF52) || defined(ARCH_ESP32)
         playShutdownMelody();
         power->shutdown();